@@ -1,5 +1,4 @@
 #include <stdint.h>
-#include <assert.h>
 
 
 /*
@@ -22,47 +21,24 @@
  *    y = (idx & 0x1)? 1 : 0
  * (where & is bitwise the AND operation)
  *
- * hcod arrays are casted to void* because table 1 to 15 are uint8_t*
+ * hcod arrays are stored as const void* because table 1 to 15 are uint8_t*
  * and 16 to 31 are uint16_t*
  *
+ * Every table is const and initialized at compile time, there is no mutable
+ * state, so the tables can be shared by any number of decoders and threads
+ *
  * Reference: ISO/IEC 11172-3:1993 Table B.7.
  */
 typedef struct {
     uint8_t num;
     uint8_t xy_max;
     uint8_t hlen_arrlen;
-    uint8_t *hlen;
-    uint8_t *hlen_cnt;
-    void *hcod;
-    uint8_t *idx;
+    const uint8_t *hlen;
+    const uint8_t *hlen_cnt;
+    const void *hcod;
+    const uint8_t *idx;
 } huffman_table_t;
 
-static void s_init_huffman_table(huffman_table_t *htb,
-                                 uint8_t htb_num,
-                                 uint8_t htb_xy_max,
-                                 uint8_t htb_hlen_arrlen,
-                                 uint8_t *htb_hlen,
-                                 uint8_t *htb_hlen_cnt,
-                                 void *htb_hcod,
-                                 uint8_t *htb_idx)
-{
-    assert(htb);
-    assert(htb_hlen_arrlen > 0);
-    assert(htb_hlen);
-    assert(htb_hlen_cnt);
-    assert(htb_hcod);
-    assert(htb_idx);
-
-    htb->num = htb_num;
-    htb->xy_max = htb_xy_max;
-    htb->hlen_arrlen = htb_hlen_arrlen;
-    htb->hlen = htb_hlen;
-    htb->hlen_cnt = htb_hlen_cnt;
-    htb->hcod = htb_hcod;
-    htb->idx = htb_idx;
-}
-
-
 static const uint8_t s_htb1_xy_max = 1;
 static const uint8_t s_htb1_hlen_arrlen = 3;
 static const uint8_t s_htb1_hlen[] = {1, 2, 3};
@@ -201,23 +177,172 @@ static const uint8_t s_htbb_idx[] = {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3
 
 
 
-static huffman_table_t s_htb_1, s_htb_2, s_htb_3, s_htb_5, s_htb_6, s_htb_7, s_htb_8, s_htb_9, s_htb_10, s_htb_11, s_htb_12, s_htb_13, s_htb_15, s_htb_16, s_htb_24, s_htb_a, s_htb_b;
-
-s_init_huffman_table(&s_htb_1, 1, 1, 3, s_htb1_hlen, s_htb1_hlen_cnt, (void *) s_htb1_hcod, s_htb1_idx);
-s_init_huffman_table(&s_htb_2, 2, 2, 4, s_htb2_hlen, s_htb2_hlen_cnt, (void *) s_htb2_hcod, s_htb2_idx);
-s_init_huffman_table(&s_htb_3, 3, 2, 4, s_htb3_hlen, s_htb3_hlen_cnt, (void *) s_htb3_hcod, s_htb3_idx);
-s_init_huffman_table(&s_htb_5, 5, 3, 5, s_htb5_hlen, s_htb5_hlen_cnt, (void *) s_htb5_hcod, s_htb5_idx);
-s_init_huffman_table(&s_htb_6, 6, 3, 6, s_htb6_hlen, s_htb6_hlen_cnt, (void *) s_htb6_hcod, s_htb6_idx);
-s_init_huffman_table(&s_htb_7, 7, 5, 9, s_htb7_hlen, s_htb7_hlen_cnt, (void *) s_htb7_hcod, s_htb7_idx);
-s_init_huffman_table(&s_htb_8, 8, 5, 9, s_htb8_hlen, s_htb8_hlen_cnt, (void *) s_htb8_hcod, s_htb8_idx);
-s_init_huffman_table(&s_htb_9, 9, 5, 7, s_htb9_hlen, s_htb9_hlen_cnt, (void *) s_htb9_hcod, s_htb9_idx);
-s_init_huffman_table(&s_htb_10, 10, 7, 9, s_htb10_hlen, s_htb10_hlen_cnt, (void *) s_htb10_hcod, s_htb10_idx);
-s_init_huffman_table(&s_htb_11, 11, 7, 10, s_htb11_hlen, s_htb11_hlen_cnt, (void *) s_htb11_hcod, s_htb11_idx);
-s_init_huffman_table(&s_htb_12, 12, 7, 8, s_htb12_hlen, s_htb12_hlen_cnt, (void *) s_htb12_hcod, s_htb12_idx);
-s_init_huffman_table(&s_htb_13, 13, 15, 17, s_htb13_hlen, s_htb13_hlen_cnt, (void *) s_htb13_hcod, s_htb13_idx);
-s_init_huffman_table(&s_htb_15, 15, 15, 11, s_htb15_hlen, s_htb15_hlen_cnt, (void *) s_htb15_hcod, s_htb15_idx);
-s_init_huffman_table(&s_htb_16, 16, 15, 15, s_htb16_hlen, s_htb16_hlen_cnt, (void *) s_htb16_hcod, s_htb16_idx);
-s_init_huffman_table(&s_htb_24, 24, 15, 9, s_htb24_hlen, s_htb24_hlen_cnt, (void *) s_htb24_hcod, s_htb24_idx);
-s_init_huffman_table(&s_htb_a, (uint_8_t) 'a', 0, 4, s_htba_hlen, s_htba_hlen_cnt, (void *) s_htba_hcod, s_htba_idx);
-s_init_huffman_table(&s_htb_b, (uint_8_t) 'b', 0, 1, s_htbb_hlen, s_htbb_hlen_cnt, (void *) s_htbb_hcod, s_htbb_idx);
-
+static const huffman_table_t s_htb_1 = {
+    .num = 1,
+    .xy_max = 1,
+    .hlen_arrlen = 3,
+    .hlen = s_htb1_hlen,
+    .hlen_cnt = s_htb1_hlen_cnt,
+    .hcod = s_htb1_hcod,
+    .idx = s_htb1_idx
+};
+
+static const huffman_table_t s_htb_2 = {
+    .num = 2,
+    .xy_max = 2,
+    .hlen_arrlen = 4,
+    .hlen = s_htb2_hlen,
+    .hlen_cnt = s_htb2_hlen_cnt,
+    .hcod = s_htb2_hcod,
+    .idx = s_htb2_idx
+};
+
+static const huffman_table_t s_htb_3 = {
+    .num = 3,
+    .xy_max = 2,
+    .hlen_arrlen = 4,
+    .hlen = s_htb3_hlen,
+    .hlen_cnt = s_htb3_hlen_cnt,
+    .hcod = s_htb3_hcod,
+    .idx = s_htb3_idx
+};
+
+static const huffman_table_t s_htb_5 = {
+    .num = 5,
+    .xy_max = 3,
+    .hlen_arrlen = 5,
+    .hlen = s_htb5_hlen,
+    .hlen_cnt = s_htb5_hlen_cnt,
+    .hcod = s_htb5_hcod,
+    .idx = s_htb5_idx
+};
+
+static const huffman_table_t s_htb_6 = {
+    .num = 6,
+    .xy_max = 3,
+    .hlen_arrlen = 6,
+    .hlen = s_htb6_hlen,
+    .hlen_cnt = s_htb6_hlen_cnt,
+    .hcod = s_htb6_hcod,
+    .idx = s_htb6_idx
+};
+
+static const huffman_table_t s_htb_7 = {
+    .num = 7,
+    .xy_max = 5,
+    .hlen_arrlen = 9,
+    .hlen = s_htb7_hlen,
+    .hlen_cnt = s_htb7_hlen_cnt,
+    .hcod = s_htb7_hcod,
+    .idx = s_htb7_idx
+};
+
+static const huffman_table_t s_htb_8 = {
+    .num = 8,
+    .xy_max = 5,
+    .hlen_arrlen = 9,
+    .hlen = s_htb8_hlen,
+    .hlen_cnt = s_htb8_hlen_cnt,
+    .hcod = s_htb8_hcod,
+    .idx = s_htb8_idx
+};
+
+static const huffman_table_t s_htb_9 = {
+    .num = 9,
+    .xy_max = 5,
+    .hlen_arrlen = 7,
+    .hlen = s_htb9_hlen,
+    .hlen_cnt = s_htb9_hlen_cnt,
+    .hcod = s_htb9_hcod,
+    .idx = s_htb9_idx
+};
+
+static const huffman_table_t s_htb_10 = {
+    .num = 10,
+    .xy_max = 7,
+    .hlen_arrlen = 9,
+    .hlen = s_htb10_hlen,
+    .hlen_cnt = s_htb10_hlen_cnt,
+    .hcod = s_htb10_hcod,
+    .idx = s_htb10_idx
+};
+
+static const huffman_table_t s_htb_11 = {
+    .num = 11,
+    .xy_max = 7,
+    .hlen_arrlen = 10,
+    .hlen = s_htb11_hlen,
+    .hlen_cnt = s_htb11_hlen_cnt,
+    .hcod = s_htb11_hcod,
+    .idx = s_htb11_idx
+};
+
+static const huffman_table_t s_htb_12 = {
+    .num = 12,
+    .xy_max = 7,
+    .hlen_arrlen = 8,
+    .hlen = s_htb12_hlen,
+    .hlen_cnt = s_htb12_hlen_cnt,
+    .hcod = s_htb12_hcod,
+    .idx = s_htb12_idx
+};
+
+static const huffman_table_t s_htb_13 = {
+    .num = 13,
+    .xy_max = 15,
+    .hlen_arrlen = 17,
+    .hlen = s_htb13_hlen,
+    .hlen_cnt = s_htb13_hlen_cnt,
+    .hcod = s_htb13_hcod,
+    .idx = s_htb13_idx
+};
+
+static const huffman_table_t s_htb_15 = {
+    .num = 15,
+    .xy_max = 15,
+    .hlen_arrlen = 11,
+    .hlen = s_htb15_hlen,
+    .hlen_cnt = s_htb15_hlen_cnt,
+    .hcod = s_htb15_hcod,
+    .idx = s_htb15_idx
+};
+
+static const huffman_table_t s_htb_16 = {
+    .num = 16,
+    .xy_max = 15,
+    .hlen_arrlen = 15,
+    .hlen = s_htb16_hlen,
+    .hlen_cnt = s_htb16_hlen_cnt,
+    .hcod = s_htb16_hcod,
+    .idx = s_htb16_idx
+};
+
+static const huffman_table_t s_htb_24 = {
+    .num = 24,
+    .xy_max = 15,
+    .hlen_arrlen = 9,
+    .hlen = s_htb24_hlen,
+    .hlen_cnt = s_htb24_hlen_cnt,
+    .hcod = s_htb24_hcod,
+    .idx = s_htb24_idx
+};
+
+static const huffman_table_t s_htb_a = {
+    .num = (uint8_t) 'a',
+    .xy_max = 0,
+    .hlen_arrlen = 4,
+    .hlen = s_htba_hlen,
+    .hlen_cnt = s_htba_hlen_cnt,
+    .hcod = s_htba_hcod,
+    .idx = s_htba_idx
+};
+
+static const huffman_table_t s_htb_b = {
+    .num = (uint8_t) 'b',
+    .xy_max = 0,
+    .hlen_arrlen = 1,
+    .hlen = s_htbb_hlen,
+    .hlen_cnt = s_htbb_hlen_cnt,
+    .hcod = s_htbb_hcod,
+    .idx = s_htbb_idx
+};
@@ -90,27 +90,27 @@ for table_number in table_numbers:
         xy_max = np.max((df.loc[:, "x"]))
         xy_max_str = static_str + const_str + "uint8_t" + ' ' + s_prefix_str + "htb" + table_number + "_xy_max = " + str(xy_max) + ';'
 
-    # Assigning the array addresses to the table struct
-    # Casting 'a' and 'b' to uint8_t as init_huffman_table takes integer parameter
+    # Assigning the array addresses to the table struct at compile time
+    # Casting 'a' and 'b' to uint8_t as num is an integer field
     table_number_cast = table_number
     if (table_number == 'a' or table_number == 'b'):
-        table_number_cast = "(uint_8_t) '" + table_number + "'"
-
-    arr_to_struct_str = ("s_init_huffman_table(&" + s_prefix_str + "htb_" + table_number + ", " +
-                         table_number_cast + ", " +
-                         str(xy_max) + ", " +
-                         str(np.size(unique_hlen)) + ", " +
-                         s_prefix_str + "htb" + table_number + "_hlen" + ", " +
-                         s_prefix_str + "htb" + table_number + "_hlen_cnt" + ", " +
-                         "(void *) " + s_prefix_str + "htb" + table_number + "_hcod" + ", " +
-                         s_prefix_str + "htb" + table_number + "_idx" + 
-                         ");")
+        table_number_cast = "(uint8_t) '" + table_number + "'"
+
+    arr_to_struct_str = (static_str + const_str + "huffman_table_t " + s_prefix_str + "htb_" + table_number + " = {\n" +
+                         indent + ".num = " + table_number_cast + ",\n" +
+                         indent + ".xy_max = " + str(xy_max) + ",\n" +
+                         indent + ".hlen_arrlen = " + str(np.size(unique_hlen)) + ",\n" +
+                         indent + ".hlen = " + s_prefix_str + "htb" + table_number + "_hlen" + ",\n" +
+                         indent + ".hlen_cnt = " + s_prefix_str + "htb" + table_number + "_hlen_cnt" + ",\n" +
+                         indent + ".hcod = " + s_prefix_str + "htb" + table_number + "_hcod" + ",\n" +
+                         indent + ".idx = " + s_prefix_str + "htb" + table_number + "_idx" + "\n" +
+                         "};")
 
     table_str = (xy_max_str + '\n' + hlen_arrlen_str + '\n' + hlen_str + '\n' +
                 hlen_cnt_str + '\n' + hcod_str + '\n' + idx_str + "\n\n\n")
 
     all_table_str += table_str
-    all_arr_to_struct_str += arr_to_struct_str + '\n'
+    all_arr_to_struct_str += arr_to_struct_str + '\n\n'
 
 
 heading_str = ("/*\n" +
@@ -133,9 +133,12 @@ heading_str = ("/*\n" +
                " *" + indent + "y = (idx & 0x1)? 1 : 0\n" +
                " * (where & is bitwise the AND operation)\n" +
                " *\n" +
-               " * hcod arrays are casted to void* because table 1 to 15 are uint8_t*\n" +
+               " * hcod arrays are stored as const void* because table 1 to 15 are uint8_t*\n" +
                " * and 16 to 31 are uint16_t*\n" +
                " *\n" +
+               " * Every table is const and initialized at compile time, there is no mutable\n" +
+               " * state, so the tables can be shared by any number of decoders and threads\n" +
+               " *\n" +
                " * Reference: ISO/IEC 11172-3:1993 Table B.7.\n" +
                " */")
 
@@ -143,56 +146,16 @@ struct_str = ("typedef struct {\n" +
               indent + "uint8_t num;\n" +
               indent + "uint8_t xy_max;\n" +
               indent + "uint8_t hlen_arrlen;\n" +
-              indent + "uint8_t *hlen;\n" +
-              indent + "uint8_t *hlen_cnt;\n" +
-              indent + "void *hcod;\n" +
-              indent + "uint8_t *idx;\n" +
+              indent + "const uint8_t *hlen;\n" +
+              indent + "const uint8_t *hlen_cnt;\n" +
+              indent + "const void *hcod;\n" +
+              indent + "const uint8_t *idx;\n" +
               "} huffman_table_t;")
 
-# add matching indent if the static is used in a function
-static_indent_str = ''
-for i in range(len(static_str)):
-    static_indent_str += ' '
-for i in range(len(s_prefix_str)):
-    static_indent_str += ' '
-
-
-init_huffman_table_str = (static_str + "void " + s_prefix_str + "init_huffman_table(huffman_table_t *htb,\n" +
-                          static_indent_str + "                        uint8_t htb_num,\n" +
-                          static_indent_str + "                        uint8_t htb_xy_max,\n" +
-                          static_indent_str + "                        uint8_t htb_hlen_arrlen,\n" +
-                          static_indent_str + "                        uint8_t *htb_hlen,\n" +
-                          static_indent_str + "                        uint8_t *htb_hlen_cnt,\n" +
-                          static_indent_str + "                        void *htb_hcod,\n" +
-                          static_indent_str + "                        uint8_t *htb_idx)\n" +
-                          "{\n" +
-                          indent + "assert(htb);\n" +
-                          indent + "assert(htb_hlen_arrlen > 0);\n" +
-                          indent + "assert(htb_hlen);\n" +
-                          indent + "assert(htb_hlen_cnt);\n" +
-                          indent + "assert(htb_hcod);\n" +
-                          indent + "assert(htb_idx);\n" +
-                          '\n' +
-                          indent + "htb->num = htb_num;\n" +
-                          indent + "htb->xy_max = htb_xy_max;\n" +
-                          indent + "htb->hlen_arrlen = htb_hlen_arrlen;\n" +
-                          indent + "htb->hlen = htb_hlen;\n" +
-                          indent + "htb->hlen_cnt = htb_hlen_cnt;\n" +
-                          indent + "htb->hcod = htb_hcod;\n" +
-                          indent + "htb->idx = htb_idx;\n"
-                          "}")
-
-# Initializing the structs
-struct_init_str = static_str + "huffman_table_t"
-for table_number in table_numbers:
-    struct_init_str += ' ' + s_prefix_str + "htb_" + table_number + ','
-struct_init_str = struct_init_str[:-1] + ';'
-
-file_text_str = ("#include <stdint.h>\n#include <assert.h>\n\n\n" + 
+file_text_str = ("#include <stdint.h>\n\n\n" +
                  heading_str + '\n' + struct_str + "\n\n" +
-                 init_huffman_table_str +
-                 "\n\n\n" + all_table_str + "\n\n" + struct_init_str + "\n\n" +
-                 all_arr_to_struct_str + '\n')
+                 all_table_str + "\n\n" +
+                 all_arr_to_struct_str.rstrip('\n') + '\n')
 
 with open(file_name + file_extension, 'w') as text_file:
     text_file.write(file_text_str)
\ No newline at end of file
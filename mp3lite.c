@@ -1,7 +1,40 @@
+/*
+ * The options use functions outside of C99, which -std=c99 hides: pread()
+ * is POSIX.1-2008, and glibc declares madvise(), syscall() and MAP_POPULATE
+ * with _DEFAULT_SOURCE only
+ */
+#if (defined (MP3LITE_USE_MADVISE) || defined (MP3LITE_USE_IO_URING)) && \
+    !defined (_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#if (defined (MP3LITE_USE_PREAD) || defined (MP3LITE_USE_IO_URING)) && \
+    !defined (_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "mp3lite.h"
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined (MP3LITE_USE_MADVISE)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined (MP3LITE_USE_PREAD) || defined (MP3LITE_USE_IO_URING)
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#if defined (MP3LITE_USE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 
 /* Maximum number of channels (2 for MPEG-1 11172-3) */
 #define NCH_MAX 2u
@@ -16,8 +49,8 @@
 /* maximum number of short block windows (3 for MPEG-1 11172-3) */
 #define NUM_WINDOW_MAX 3u
 
-/* Uncompressed frame size, in bytes, for MPEG-1 Audio Layer 3 */
-#define FRAME_SIZE (1152u / 8u)
+/* Number of frequency lines (and PCM samples) per granule per channel */
+#define GRANULE_LEN 576u
 
 /* Scalefactor table array lengths */
 #define LONG_BLOCK_LEN  21
@@ -208,9 +241,8 @@ static uint8_t s_decode_frame_header(const uint32_t frame_header,
 /*
  * \param frame_header  frame header in system endianness
  *
- * \return  true:   MPEG version 1
- *          false:  reserved (header_info->ver = 0) 
-                    2 & 2.5 (for 2.5, header_info->ver = 25)
+ * \return  true:   MPEG version 1, 2 & 2.5 (for 2.5, header_info->ver = 25)
+ *          false:  reserved (header_info->ver = 0)
  */
 static bool s_decode_frame_header_ver(uint32_t frame_header, 
                                       header_info_t *header_info);
@@ -228,6 +260,8 @@ static bool s_decode_frame_header_layer(const uint32_t frame_header,
                                         header_info_t *header_info);
 
 /*
+ * MPEG-2 and 2.5 (LSF, lower sampling frequencies) share a bitrate table
+ *
  * \param frame_header  frame header in system endianness
  *
  * \return  if bitrate index is 0000, this function returns success
@@ -236,6 +270,8 @@ static bool s_decode_frame_header_layer(const uint32_t frame_header,
 static bool s_decode_frame_header_bitrate(const uint32_t frame_header,
                                           header_info_t *header_info);
 /*
+ * The MPEG-2 frequencies are half of the MPEG-1 ones, MPEG-2.5 a quarter
+ *
  * \param frame_header  frame header in system endianness
  *
  * \return  if the frequency index is 11 (i.e. reserved), 
@@ -245,12 +281,34 @@ static bool s_decode_frame_header_freq(const uint32_t frame_header,
                                        header_info_t *header_info);
 
 /*
- * \param frame_header  frame header in system endianness
- *
- * \return  Huffman coded frame length in bytes,
- *          excludes the header, padding, and side information
+ * \return  Frame length in bytes, including the header, CRC, side information,
+ *          main data and padding
+ *          If the bitrate is free (0), this function returns 0
  */
-static uint32_t s_frame_compressed_len(header_info_t *header_info);
+static uint32_t s_frame_len(const header_info_t *header_info);
+
+/*
+ * \return  Side information length in bytes, 17/32 (mono/stereo) for MPEG-1,
+ *          9/17 for MPEG-2/2.5
+ */
+static uint32_t s_side_info_len(const header_info_t *header_info);
+
+/*
+ * \return  Huffman coded frame length in bytes (the main data slot),
+ *          excludes the header, CRC, and side information,
+ *          includes the padding
+ */
+static uint32_t s_frame_compressed_len(const header_info_t *header_info);
+
+/*
+ * \return  Number of granules in a frame, 2 for MPEG-1, 1 for MPEG-2/2.5
+ */
+static uint8_t s_num_granules(const header_info_t *header_info);
+
+/*
+ * \return  Number of PCM samples per channel in a frame
+ */
+static uint32_t s_samples_per_frame(const header_info_t *header_info);
 
 /*****************************************************************************
  *                                                                           *
@@ -318,11 +376,9 @@ static bool s_decode_frame_header_ver(const uint32_t frame_header,
             break;
         case 0x00100000u:
             header_info->ver = 2;
-            success = false;
             break;
         case 0x00000000u:
             header_info->ver = 25;
-            success = false;
             break;
         default:
             header_info->ver = 0;
@@ -370,7 +426,12 @@ static bool s_decode_frame_header_bitrate(const uint32_t frame_header,
     else
     {
         static const uint16_t s_bitrate_layer3[] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
-        header_info->bitrate = s_bitrate_layer3[bitrate_idx];
+        static const uint16_t s_bitrate_layer3_lsf[] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+
+        /* Version ID bit 19 is clear for MPEG-2 and 2.5 */
+        header_info->bitrate = (frame_header & 0x00080000u) ?
+                               s_bitrate_layer3[bitrate_idx] :
+                               s_bitrate_layer3_lsf[bitrate_idx];
     }
 
     return success;
@@ -401,17 +462,75 @@ static bool s_decode_frame_header_freq(const uint32_t frame_header,
             break;
     }
 
+    /* Halved for MPEG-2 (version ID 10), quartered for MPEG-2.5 (00) */
+    switch (frame_header & 0x00180000u)
+    {
+        case 0x00100000u:
+            header_info->freq = (uint16_t) (header_info->freq >> 1);
+            break;
+        case 0x00000000u:
+            header_info->freq = (uint16_t) (header_info->freq >> 2);
+            break;
+        default:
+            break;
+    }
+
     return success;
 }
 
 
-static uint32_t s_frame_compressed_len(header_info_t *header_info)
+static uint32_t s_frame_len(const header_info_t *header_info)
 {
-    return ((FRAME_SIZE * header_info->bitrate / header_info->freq) +
+    assert(header_info);
+    assert(header_info->freq);
+
+    /* bitrate is in kbits/s, 144 bytes per kbits/s for MPEG-1, 72 for LSF */
+    const uint32_t frame_size = s_samples_per_frame(header_info) / 8u;
+
+    return ((frame_size * 1000u * header_info->bitrate / header_info->freq) +
             header_info->padding);
 }
 
 
+static uint32_t s_side_info_len(const header_info_t *header_info)
+{
+    assert(header_info);
+
+    if (header_info->ver == 1u)
+    {
+        return (header_info->mode == 3u) ? 17u : 32u;
+    }
+
+    return (header_info->mode == 3u) ? 9u : 17u;
+}
+
+
+static uint32_t s_frame_compressed_len(const header_info_t *header_info)
+{
+    const uint32_t header_len = 4u;
+    const uint32_t crc_len = (header_info->protection) ? 2u : 0;
+
+    return (s_frame_len(header_info) - header_len - crc_len -
+            s_side_info_len(header_info));
+}
+
+
+static uint8_t s_num_granules(const header_info_t *header_info)
+{
+    assert(header_info);
+
+    return (header_info->ver == 1u) ? 2u : 1u;
+}
+
+
+static uint32_t s_samples_per_frame(const header_info_t *header_info)
+{
+    assert(header_info);
+
+    return s_num_granules(header_info) * GRANULE_LEN;
+}
+
+
 /*****************************************************************************
  *                                                                           *
  * Typedef's and function prototypes for decoding side information           *
@@ -437,12 +556,17 @@ static uint32_t s_frame_compressed_len(header_info_t *header_info)
  * -------
  * part2_3_length   Number of BITS used for scalefactors and Huffman code data
  *
+ * scalefac_compress    4 bits for MPEG-1, 9 bits for MPEG-2/2.5
+ *
+ * preflag          Not transmitted for MPEG-2/2.5, derived from
+ *                  scalefac_compress (ISO/IEC 13818-3: 1995 2.4.3.2)
+ *
  */
 typedef struct {
     uint16_t part2_3_length;
     uint16_t big_values;
     uint8_t global_gain;
-    uint8_t scalefac_compress;
+    uint16_t scalefac_compress;
     uint8_t window_switching_flag;
     uint8_t table_select[3];
 
@@ -475,10 +599,14 @@ typedef struct {
  *
  * Members
  * -------
+ * main_data_begin          9 bits for MPEG-1, 8 bits for MPEG-2/2.5
+ *
  * scfsi[idx]               idx = scfsi_band * NCH_MAX + ch
+ *                          All 0 for MPEG-2/2.5, which has no scfsi
  *
  * gr_ch[idx]               Information unique to each granule and channel
  *                          idx = gr * NCH_MAX + ch
+ *                          Only gr = 0 for MPEG-2/2.5 (single granule)
  */
 typedef struct {
     uint16_t main_data_begin;
@@ -536,6 +664,9 @@ static bool s_decode_side_info_gr_ch(const uint8_t *side_info_ptr,
  * Decoding side information for EACH granule and channel, This function is a
  * helper function for s_decode_side_info_gr_ch
  *
+ * For MPEG-2/2.5 the layout is the one of ISO/IEC 13818-3: 1995 2.4.1.7,
+ * a 9 bits scalefac_compress and no preflag; gr_ch_ptr MUST hold 9 bytes
+ *
  * \param gr_ch_ptr     Pointer to the start of side_info for the [gr][ch]
  *                      must be byte-aligned
  *
@@ -559,12 +690,41 @@ static void s_decode_side_info_gr_ch_win_sw_flag(const uint8_t *gr_ch_ptr,
                                                  const uint8_t win_sw_flag,
                                                  side_info_gr_ch_t *cur_gr_ch);
 
+/*
+ * Helper function for s_decode_side_info_gr_ch_loop, decodes the MPEG-2/2.5
+ * information after global_gain
+ *
+ * The 9 bits scalefac_compress is 5 bits longer than the MPEG-1 one, the
+ * rest is shifted back by 5 bits and decoded as MPEG-1
+ *
+ * \param gr_ch_ptr     9 bytes, see s_decode_side_info_gr_ch_loop
+ */
+static void s_decode_side_info_gr_ch_lsf(const uint8_t *gr_ch_ptr,
+                                         const uint8_t ch,
+                                         side_info_gr_ch_t *cur_gr_ch,
+                                         const header_info_t *header_info);
+
 /*
  * Calculate the byte offset of the second granule from main_data_begin
  */
 static uint32_t s_next_granule_pos(const side_info_t *side_info,
                                    const header_info_t *header_info);
 
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * Adding up part2_3_length of every channel of the first ngr granules
+ *
+ * \param ngr   Number of granules, 1 or 2, at most s_num_granules()
+ *
+ * \return      Number of main data bits of the granules
+ */
+static uint32_t s_main_data_bits(const side_info_t *side_info,
+                                 const header_info_t *header_info,
+                                 const uint8_t ngr);
+
+#endif
+
 /*****************************************************************************
  *                                                                           *
  * Source code for decoding side information                                 *
@@ -581,8 +741,11 @@ static uint8_t s_decode_side_info(const uint8_t *side_info_ptr,
 
     uint8_t result = 0;
 
+    /* 9 bits for MPEG-1, 8 bits for MPEG-2/2.5 */
     uint16_t main_data_begin = s_copy_bitstream_u16(side_info_ptr);
-    side_info->main_data_begin = main_data_begin >> 7;
+    side_info->main_data_begin = (header_info->ver == 1u) ?
+                                 (uint16_t) (main_data_begin >> 7) :
+                                 (uint16_t) (main_data_begin >> 8);
 
     bool scfsi_b = s_decode_side_info_scfsi(side_info_ptr, 
                                             side_info, 
@@ -626,6 +789,13 @@ static bool s_decode_side_info_scfsi(const uint8_t *side_info_ptr,
     
     bool success = false;
 
+    /* No scalefactor selection in MPEG-2/2.5, only one granule */
+    if (header_info->ver != 1u)
+    {
+        memset(side_info->scfsi, 0, sizeof(side_info->scfsi));
+        return (header_info->mode <= 3u);
+    }
+
     uint16_t scfsi_temp = s_copy_bitstream_u16(&side_info_ptr[1]);
     uint8_t bitshift = 0;
     uint8_t foo = 0;
@@ -647,7 +817,7 @@ static bool s_decode_side_info_scfsi(const uint8_t *side_info_ptr,
                     bitshift--;
                 }
             }
-            success = false;
+            success = true;
             break;
         
         /* single channel */
@@ -683,14 +853,21 @@ static bool s_decode_side_info_gr_ch(const uint8_t *side_info_ptr,
     bool success_arr[2u * NCH_MAX];
 
     /* gr_ch_ptr to be aligned the byte boundary */
-    uint8_t gr_ch_ptr[8u];// 59 bits for each [gr][ch]; gr_ch_len = 8
+    uint8_t gr_ch_ptr[9u];// 59 (MPEG-1) or 63 (LSF) bits for each [gr][ch]
+
+    /* The side information, padded so that aligning never reads past it */
+    uint8_t side_info_buf[32u + 2u] = {0};
+    memcpy(side_info_buf, side_info_ptr, s_side_info_len(header_info));
 
     /* data precede [gr][ch]: 18 bits for mono, 20 bits for dual channels */
-    /* for MPEG2/2.5, nch & pre_gr_ch_bits needs to change                */
+    /* MPEG-2/2.5: 9 bits for mono, 10 bits for dual channels             */
+    const bool lsf_b = (header_info->ver != 1u);
     const uint8_t nch = (header_info->mode == 3u) ? 1u : 2u;
-    const uint8_t pre_gr_ch_bits = (header_info->mode == 3u) ? 18u : 20u;
-    const uint8_t gr_ch_bitsize = 59u;
-    const uint8_t gr_ch_len = 8u; /* in bytes */
+    const uint8_t ngr = s_num_granules(header_info);
+    const uint8_t pre_gr_ch_bits = (lsf_b) ? ((nch == 1u) ? 9u : 10u) :
+                                             ((nch == 1u) ? 18u : 20u);
+    const uint8_t gr_ch_bitsize = (lsf_b) ? 63u : 59u;
+    const uint8_t gr_ch_len = (lsf_b) ? 9u : 8u; /* in bytes */
 
     /* Initiate variables outside the loop */
     uint32_t preceding_bits = 0;
@@ -698,21 +875,22 @@ static bool s_decode_side_info_gr_ch(const uint8_t *side_info_ptr,
     uint8_t bitshift = 0;
     uint8_t i = 0;
 
-    for (uint8_t gr = 0; gr < 2u; ++gr)
+    for (uint8_t gr = 0; gr < ngr; ++gr)
     {
         for (uint8_t ch = 0; ch < nch; ++ch)
         {
             /* Number of bits precede the current [gr][ch] from side_info_ptr */
-            /* preceding_bits = pre_gr_ch_bits + (gr + ch) * gr_ch_bitsize*/
+            /* preceding_bits = pre_gr_ch_bits +                              */
+            /*                  (gr * nch + ch) * gr_ch_bitsize               */
             preceding_bits = ((uint32_t) pre_gr_ch_bits + 
-                              (((uint32_t) gr + (uint32_t) ch) * 
+                              (((uint32_t) gr * nch + (uint32_t) ch) *
                               (uint32_t) gr_ch_bitsize));
 
             /* Index of the current [gr][ch] in side_info_ptr */
             idx = preceding_bits / 8u;
             bitshift = (uint8_t) preceding_bits % 8u;
 
-            s_align_array(gr_ch_ptr, &side_info_ptr[idx], bitshift, gr_ch_len);
+            s_align_array(gr_ch_ptr, &side_info_buf[idx], bitshift, gr_ch_len);
 
             /* Decoding [gr][ch] */
             success_arr[i] = s_decode_side_info_gr_ch_loop(gr_ch_ptr, gr, ch, 
@@ -723,7 +901,7 @@ static bool s_decode_side_info_gr_ch(const uint8_t *side_info_ptr,
     }
 
     success = true;
-    for (uint8_t j = 0; j < (2u * nch); ++j)
+    for (uint8_t j = 0; j < (ngr * nch); ++j)
     {
         success = success && success_arr[j];
     }
@@ -758,22 +936,30 @@ static bool s_decode_side_info_gr_ch_loop(const uint8_t *gr_ch_ptr,
     foo = s_copy_bitstream_u16(&gr_ch_ptr[2]);
     cur_gr_ch->global_gain = (uint8_t) ((foo & 0x07F8u) >> 3);
 
-    foo = s_copy_bitstream_u16(&gr_ch_ptr[3]);
-    cur_gr_ch->scalefac_compress = (uint8_t) ((foo & 0x0780u) >> 7);
+    if (header_info->ver != 1u)
+    {
+        s_decode_side_info_gr_ch_lsf(gr_ch_ptr, ch, cur_gr_ch, header_info);
+    }
+    else
+    {
+        foo = s_copy_bitstream_u16(&gr_ch_ptr[3]);
+        cur_gr_ch->scalefac_compress = (uint8_t) ((foo & 0x0780u) >> 7);
 
-    uint8_t win_flag = (gr_ch_ptr[4] & 0x40u) >> 6;
-    cur_gr_ch->window_switching_flag = win_flag;
+        uint8_t win_flag = (gr_ch_ptr[4] & 0x40u) >> 6;
+        cur_gr_ch->window_switching_flag = win_flag;
 
-    s_decode_side_info_gr_ch_win_sw_flag(gr_ch_ptr, win_flag, cur_gr_ch);
+        s_decode_side_info_gr_ch_win_sw_flag(gr_ch_ptr, win_flag, cur_gr_ch);
 
-    /* |     7     | */
-    /* | IJK- ---- | */
-    cur_gr_ch->preflag = (gr_ch_ptr[7] & 0x80u) >> 7;
-    cur_gr_ch->scalefac_scale = (gr_ch_ptr[7] & 0x40u) >> 6;
-    cur_gr_ch->count1table_select = (gr_ch_ptr[7] & 0x20u) >> 5;
+        /* |     7     | */
+        /* | IJK- ---- | */
+        cur_gr_ch->preflag = (gr_ch_ptr[7] & 0x80u) >> 7;
+        cur_gr_ch->scalefac_scale = (gr_ch_ptr[7] & 0x40u) >> 6;
+        cur_gr_ch->count1table_select = (gr_ch_ptr[7] & 0x20u) >> 5;
+    }
 
-    /// TODO: currently there is no error detection
-    success = true;
+    /* block_type 0 is forbidden when window_switching_flag is set */
+    success = !((cur_gr_ch->window_switching_flag == 1u) &&
+                (cur_gr_ch->block_type == 0u));
     return success;
 }
 
@@ -837,22 +1023,81 @@ static void s_decode_side_info_gr_ch_win_sw_flag(const uint8_t *gr_ch_ptr,
 }
 
 
+static void s_decode_side_info_gr_ch_lsf(const uint8_t *gr_ch_ptr,
+                                         const uint8_t ch,
+                                         side_info_gr_ch_t *cur_gr_ch,
+                                         const header_info_t *header_info)
+{
+    assert(gr_ch_ptr && cur_gr_ch && header_info);
+
+    /* |     3     |     4     | */
+    /* | GGGG GSSS | SSSS SSH- | */
+    uint16_t foo = s_copy_bitstream_u16(&gr_ch_ptr[3]);
+    cur_gr_ch->scalefac_compress = (uint16_t) ((foo & 0x07FCu) >> 2);
+
+    /* The MPEG-1 layout from window_switching_flag on */
+    uint8_t rest_ptr[8u];
+    s_align_array(rest_ptr, gr_ch_ptr, 5u, 8u);
+
+    uint8_t win_flag = (rest_ptr[4] & 0x40u) >> 6;
+    cur_gr_ch->window_switching_flag = win_flag;
+
+    s_decode_side_info_gr_ch_win_sw_flag(rest_ptr, win_flag, cur_gr_ch);
+
+    /* |     7     | */
+    /* | JK-- ---- | */
+    cur_gr_ch->scalefac_scale = (rest_ptr[7] & 0x80u) >> 7;
+    cur_gr_ch->count1table_select = (rest_ptr[7] & 0x40u) >> 6;
+
+    /* The right channel of intensity stereo has no pre-emphasis */
+    bool intensity_b = ((ch == 1u) && (header_info->mode == 1u) &&
+                        (header_info->mode_ext & 0x01u));
+    cur_gr_ch->preflag = (!intensity_b &&
+                          (cur_gr_ch->scalefac_compress >= 500u)) ? 1u : 0;
+}
+
+
 static uint32_t s_next_granule_pos(const side_info_t *side_info,
                                    const header_info_t *header_info)
 {
     ///TODO: Verify (Why do we need part2_3_length accroding to page 25???)
     assert(side_info && header_info);
     
-    /* for MPEG2/2.5 side_info_len needs to change */
     const uint32_t header_len = 4u;
     const uint32_t crc_len = (header_info->protection) ? 2 : 0;
-    const uint8_t side_info_len = (header_info->mode == 3u) ? 17u : 32u;
+    const uint32_t side_info_len = s_side_info_len(header_info);
     
     return ((uint32_t) (side_info->main_data_begin) + 
             header_len + crc_len + side_info_len);
 }
 
 
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+static uint32_t s_main_data_bits(const side_info_t *side_info,
+                                 const header_info_t *header_info,
+                                 const uint8_t ngr)
+{
+    assert(side_info && header_info &&
+           (ngr <= s_num_granules(header_info)));
+
+    const uint8_t nch = (header_info->mode == 3u) ? 1u : 2u;
+    uint32_t bits = 0;
+
+    for (uint8_t gr = 0; gr < ngr; ++gr)
+    {
+        for (uint8_t ch = 0; ch < nch; ++ch)
+        {
+            bits += side_info->gr_ch[s_gr_ch_idx(gr, ch)].part2_3_length;
+        }
+    }
+
+    return bits;
+}
+
+#endif
+
+
 /*****************************************************************************
 *                                                                           *
 * Typedef's and function prototypes for decoding scalefactors (scalefac)   *
@@ -976,6 +1221,31 @@ static uint32_t s_decode_scalefac_part2_length(const uint8_t gr,
                                                const uint8_t ch,
                                                const uint8_t scfsi_band,
                                                const side_info_t *side_info);
+
+/*
+ * MPEG-2/2.5 scalefactors are sent in four partitions of scalefactor bands,
+ * each with its own bitsize (ISO/IEC 13818-3: 1995 2.4.3.2)
+ *
+ * The right channel of intensity stereo (mode_ext bit 0) uses the second
+ * half of the table, with scalefac_compress / 2; its lowest bit is the
+ * intensity_scale of the intensity positions
+ *
+ * \param slen          4 bitsizes, will be modified by the function
+ *
+ * \param nr_of_sfb     4 numbers of scalefactor bands (for short blocks,
+ *                      counting each window), will be modified by the
+ *                      function
+ *
+ * \param ch            current channel, starts at 0
+ *
+ * \return              The number of BITS used to encode scalefactors
+ *                      (part2_length)
+ */
+static uint32_t s_decode_scalefac_lsf_partition(uint8_t *slen,
+                                                uint8_t *nr_of_sfb,
+                                                const uint8_t ch,
+                                                const side_info_gr_ch_t *gr_ch,
+                                                const header_info_t *header_info);
  
 /* 
  * Obtaining the number of bits used for the transmission of the scalefactor
@@ -1291,12 +1561,112 @@ static uint32_t s_decode_scalefac_part2_length(const uint8_t gr,
 }
 
 
+static uint32_t s_decode_scalefac_lsf_partition(uint8_t *slen,
+                                                uint8_t *nr_of_sfb,
+                                                const uint8_t ch,
+                                                const side_info_gr_ch_t *gr_ch,
+                                                const header_info_t *header_info)
+{
+    assert(slen && nr_of_sfb && gr_ch && header_info);
+    assert(ch < NCH_MAX);
+
+    /* [table][long, short, mixed][partition], ISO/IEC 13818-3 Table B.1 */
+    static const uint8_t s_nr_of_sfb[6][3][4] = {
+        {{ 6,  5,  5, 5}, { 9,  9,  9, 9}, { 6,  9,  9, 9}},
+        {{ 6,  5,  7, 3}, { 9,  9, 12, 6}, { 6,  9, 12, 6}},
+        {{11, 10,  0, 0}, {18, 18,  0, 0}, {15, 18,  0, 0}},
+        {{ 7,  7,  7, 0}, {12, 12, 12, 0}, { 6, 15, 12, 0}},
+        {{ 6,  6,  6, 3}, {12,  9,  9, 6}, { 6, 12,  9, 6}},
+        {{ 8,  8,  5, 0}, {15, 12,  9, 0}, { 6, 18,  9, 0}}
+    };
+
+    const bool intensity_b = ((ch == 1u) && (header_info->mode == 1u) &&
+                              (header_info->mode_ext & 0x01u));
+    uint32_t sfc = gr_ch->scalefac_compress;
+    uint8_t table = 0;
+
+    memset(slen, 0, 4u);
+
+    if (!intensity_b)
+    {
+        if (sfc < 400u)
+        {
+            slen[0] = (uint8_t) ((sfc >> 4) / 5u);
+            slen[1] = (uint8_t) ((sfc >> 4) % 5u);
+            slen[2] = (uint8_t) ((sfc & 0x0Fu) >> 2);
+            slen[3] = (uint8_t) (sfc & 0x03u);
+            table = 0;
+        }
+        else if (sfc < 500u)
+        {
+            sfc -= 400u;
+            slen[0] = (uint8_t) ((sfc >> 2) / 5u);
+            slen[1] = (uint8_t) ((sfc >> 2) % 5u);
+            slen[2] = (uint8_t) (sfc & 0x03u);
+            table = 1;
+        }
+        else
+        {
+            sfc -= 500u;
+            slen[0] = (uint8_t) (sfc / 3u);
+            slen[1] = (uint8_t) (sfc % 3u);
+            table = 2;
+        }
+    }
+    else
+    {
+        sfc >>= 1;
+        if (sfc < 180u)
+        {
+            slen[0] = (uint8_t) (sfc / 36u);
+            slen[1] = (uint8_t) ((sfc % 36u) / 6u);
+            slen[2] = (uint8_t) ((sfc % 36u) % 6u);
+            table = 3;
+        }
+        else if (sfc < 244u)
+        {
+            sfc -= 180u;
+            slen[0] = (uint8_t) ((sfc & 0x3Fu) >> 4);
+            slen[1] = (uint8_t) ((sfc & 0x0Fu) >> 2);
+            slen[2] = (uint8_t) (sfc & 0x03u);
+            table = 4;
+        }
+        else
+        {
+            sfc -= 244u;
+            slen[0] = (uint8_t) (sfc / 3u);
+            slen[1] = (uint8_t) (sfc % 3u);
+            table = 5;
+        }
+    }
+
+    /* 0: long blocks, 1: short blocks, 2: mixed blocks */
+    uint8_t block = 0;
+    if (gr_ch->window_switching_flag && (gr_ch->block_type == 2u))
+    {
+        block = (gr_ch->mixed_block_flag == 1u) ? 2u : 1u;
+    }
+
+    uint32_t part2_length = 0;
+    for (uint8_t i = 0; i < 4u; ++i)
+    {
+        nr_of_sfb[i] = s_nr_of_sfb[table][block][i];
+        part2_length += (uint32_t) slen[i] * nr_of_sfb[i];
+    }
+
+    return part2_length;
+}
+
+
 static bool s_decode_scalefac(const uint8_t *main_data_ptr,
                               const side_info_t *side_info,
                               const header_info_t *header_info)
 {
     bool success = false;
 
+    /// TODO: main data is not read yet
+    (void) main_data_ptr;
+
     const uint8_t nch = (header_info->mode == 3u) ? 1u : 2u;
 
     // /* gr_ch_ptr to be aligned the byte boundary */
@@ -1304,7 +1674,7 @@ static bool s_decode_scalefac(const uint8_t *main_data_ptr,
 
     
 
-    for (uint8_t gr = 0; gr < 2u; ++gr)
+    for (uint8_t gr = 0; gr < s_num_granules(header_info); ++gr)
     {
         for (uint8_t ch = 0; ch < nch; ++ch)
         {
@@ -1343,11 +1713,4342 @@ static bool s_decode_scalefac(const uint8_t *main_data_ptr,
             }
             else
             {
-                if (side_info->scfsi[s_scfsi_idx(ch, 0)])
+                /// TODO: long block scalefactors (depends on scfsi[ch][band])
             }
  
         }
     }
 
     return success;
-}
\ No newline at end of file
+}
+
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*****************************************************************************
+ *                                                                           *
+ * Function prototypes for downmixing stereo to mono                         *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Number of channels that have to go through the IMDCT and the polyphase
+ * synthesis filterbank
+ *
+ * When mono output is requested for a stereo or joint stereo frame, the two
+ * channels are averaged in the frequency domain after stereo processing, and
+ * only one IMDCT and one synthesis are run. Both stages are linear, so the
+ * result is the same as downmixing the PCM
+ *
+ * Dual channel frames (mode 2) carry two independent programs and are never
+ * mixed together
+ *
+ * \param mono_output   true if the caller asked for mono output
+ *
+ * \return              1: single channel, or mono output requested for
+ *                         stereo/joint stereo (mode 0/1)
+ *                      2: otherwise
+ */
+static uint8_t s_synthesis_nch(const header_info_t *header_info,
+                               const bool mono_output);
+
+/* Until there is a spectrum to downmix, only the unit tests build these */
+#if defined (MP3LITE_TEST)
+
+/*
+ * The spectra of both channels can only be averaged before the IMDCT if both
+ * channels use the same windows, otherwise the IMDCT is not the same linear
+ * map for both channels
+ *
+ * If this function returns false, the downmix has to be done on the IMDCT
+ * output instead (before the synthesis), which still saves one synthesis
+ *
+ * \param gr_ch_0   Side information for [gr][ch = 0]
+ *
+ * \param gr_ch_1   Side information for [gr][ch = 1]
+ *
+ * \return          true if both channels have the same block_type and
+ *                  mixed_block_flag
+ */
+static bool s_downmix_spectrum_b(const side_info_gr_ch_t *gr_ch_0,
+                                 const side_info_gr_ch_t *gr_ch_1);
+
+/*
+ * Averaging two channels of one granule into the first channel,
+ * xr_0[i] = (xr_0[i] + xr_1[i]) / 2
+ *
+ * Used on the stereo processed spectra, or on the IMDCT output if
+ * s_downmix_spectrum_b() returns false
+ *
+ * \param xr_0  Channel 0, GRANULE_LEN elements, overwritten with the average
+ *
+ * \param xr_1  Channel 1, GRANULE_LEN elements
+ *              xr_0 and xr_1 MUST not alias
+ */
+static void s_downmix_mono(float *xr_0, const float *xr_1);
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for downmixing stereo to mono                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint8_t s_synthesis_nch(const header_info_t *header_info,
+                               const bool mono_output)
+{
+    assert(header_info);
+
+    uint8_t nch = 2;
+
+    switch (header_info->mode)
+    {
+        /* stereo and joint stereo */
+        case 0:
+        case 1:
+            nch = (mono_output) ? 1u : 2u;
+            break;
+
+        /* dual channel */
+        case 2:
+            nch = 2;
+            break;
+
+        /* single channel */
+        case 3:
+        default:
+            nch = 1;
+            break;
+    }
+
+    return nch;
+}
+
+
+#if defined (MP3LITE_TEST)
+
+static bool s_downmix_spectrum_b(const side_info_gr_ch_t *gr_ch_0,
+                                 const side_info_gr_ch_t *gr_ch_1)
+{
+    assert(gr_ch_0 && gr_ch_1);
+
+    return ((gr_ch_0->block_type == gr_ch_1->block_type) &&
+            (gr_ch_0->mixed_block_flag == gr_ch_1->mixed_block_flag));
+}
+
+
+static void s_downmix_mono(float *xr_0, const float *xr_1)
+{
+    assert(xr_0 && xr_1);
+    assert(xr_0 != xr_1);
+
+    for (uint32_t i = 0; i < GRANULE_LEN; ++i)
+    {
+        xr_0[i] = 0.5f * (xr_0[i] + xr_1[i]);
+    }
+}
+
+#endif
+
+#endif
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for loudness measurement                *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * ITU-R BS.1770-4 / EBU R128 loudness of the synthesis output
+ *
+ * Samples are K-weighted (a high shelf and a high pass, as biquads) and
+ * their mean square is summed over 100 ms sub-blocks. The 400 ms gating
+ * blocks (75 % overlap) and the 3 s short-term blocks of the loudness range
+ * (EBU Tech 3342) are made of sub-blocks, and land in histograms of 0.1 LU
+ * bins, so nothing grows with the length of the stream
+ */
+
+/* Loudness of a mean square of 1.0, -0.691 LUFS */
+#define LOUDNESS_OFFSET (-0.691)
+
+/* Histograms from LOUDNESS_GATE_ABS to +5 LUFS, 0.1 LU per bin */
+#define LOUDNESS_GATE_ABS   (-70.0)
+#define LOUDNESS_HIST_LEN   750u
+#define LOUDNESS_BIN_PER_LU 10.0
+
+/* Sub-blocks of 100 ms, 4 per gating block, 30 per short-term block */
+#define LOUDNESS_SUB_PER_SEC    10u
+#define LOUDNESS_SUB_PER_BLOCK  4u
+#define LOUDNESS_SUB_PER_ST     30u
+
+/* Sub-blocks kept per channel, a channel may run a frame ahead of another */
+#define LOUDNESS_SUB_RING 64u
+
+/* Relative gates as energy ratios, -10 LU (integrated) and -20 LU (range) */
+#define LOUDNESS_GATE_REL       0.1
+#define LOUDNESS_GATE_REL_LRA   0.01
+
+/* ReplayGain 2.0 reference level in LUFS */
+#define LOUDNESS_REPLAY_GAIN_REF    (-18.0)
+
+/*
+ * True peak: 4 times oversampling with a 48 taps windowed sinc, phase 0 is
+ * the sample itself, the 3 other phases have 12 taps each
+ */
+#define TRUE_PEAK_PHASES    3u
+#define TRUE_PEAK_TAPS      12u
+
+/*
+ * Members
+ * -------
+ * freq             Sampling frequency the filters are set for, 0 before the
+ *                  first frame
+ *
+ * nch              Number of channels measured
+ *
+ * k_coef           K-weighting coefficients for freq, see s_k_weighting()
+ *
+ * k_state          Transposed direct form II state of the two biquads,
+ *                  idx = ch * 4 + i
+ *
+ * sub_len          Samples in the current sub-block of each channel, see
+ *                  s_loudness_sub_len()
+ *
+ * sub_count        Samples in the current sub-block of each channel
+ *
+ * sub_acc          Sum of squares of the current sub-block of each channel
+ *
+ * sub_energy       Mean square of the last sub-blocks of each channel,
+ *                  idx = ch * LOUDNESS_SUB_RING + (sub % LOUDNESS_SUB_RING)
+ *
+ * nsub             Sub-blocks completed by each channel
+ *
+ * nsub_all         Sub-blocks completed by every channel and counted in the
+ *                  histograms
+ *
+ * tp_buf           Last TRUE_PEAK_TAPS samples of each channel, twice in a
+ *                  row so that they can be read in one piece from tp_pos,
+ *                  idx = ch * 2 * TRUE_PEAK_TAPS + i
+ *
+ * tp_pos           Oldest sample in tp_buf of each channel
+ *
+ * true_peak        Largest oversampled absolute value
+ *
+ * sample_peak      Largest absolute sample value
+ *
+ * block_count      Gating blocks per bin
+ *
+ * block_energy     Sum of the mean squares of the gating blocks per bin
+ *
+ * st_count         Short-term blocks per bin
+ *
+ * st_energy        Sum of the mean squares of the short-term blocks per bin
+ */
+typedef struct {
+    uint32_t freq;
+    uint8_t nch;
+    const double *k_coef;
+    double k_state[NCH_MAX * 4u];
+
+    uint32_t sub_len[NCH_MAX];
+    uint32_t sub_count[NCH_MAX];
+    double sub_acc[NCH_MAX];
+    double sub_energy[NCH_MAX * LOUDNESS_SUB_RING];
+    uint64_t nsub[NCH_MAX];
+    uint64_t nsub_all;
+
+    float tp_buf[NCH_MAX * 2u * TRUE_PEAK_TAPS];
+    uint32_t tp_pos[NCH_MAX];
+    float true_peak;
+    float sample_peak;
+
+    uint64_t block_count[LOUDNESS_HIST_LEN];
+    double block_energy[LOUDNESS_HIST_LEN];
+    uint64_t st_count[LOUDNESS_HIST_LEN];
+    double st_energy[LOUDNESS_HIST_LEN];
+} loudness_t;
+
+/*
+ * Members
+ * -------
+ * integrated       Integrated loudness in LUFS
+ *
+ * range            Loudness range in LU
+ *
+ * true_peak        True peak in dBTP (4 times oversampling)
+ *
+ * sample_peak      Sample peak in dBFS
+ *
+ * replay_gain      Gain in dB to bring the stream to LOUDNESS_REPLAY_GAIN_REF
+ */
+typedef struct {
+    double integrated;
+    double range;
+    double true_peak;
+    double sample_peak;
+    double replay_gain;
+} loudness_result_t;
+
+/*
+ * \return  10 * log10(x) for x > 0, without libm
+ */
+static double s_db10(const double x);
+
+/* Until there is a synthesis, only the unit tests feed the meter */
+#if defined (MP3LITE_TEST)
+
+/*
+ * K-weighting filter of BS.1770-4 at a sampling frequency
+ *
+ * \return  b0, b1, b2, a1, a2 of the high shelf then a1, a2 of the high
+ *          pass (b0 = 1, b1 = -2, b2 = 1), NULL if freq is not an MPEG
+ *          sampling frequency
+ */
+static const double *s_k_weighting(const uint32_t freq);
+
+/*
+ * Initializing an empty meter, the format is set by s_loudness_set_format()
+ */
+static void s_loudness_init(loudness_t *loudness);
+
+/*
+ * Setting the sampling frequency and the number of channels, the filters
+ * and the current sub-blocks start over if either changes, the histograms
+ * are kept
+ */
+static void s_loudness_set_format(loudness_t *loudness,
+                                  const uint32_t freq,
+                                  const uint8_t nch);
+
+/*
+ * Length of a sub-block, freq / LOUDNESS_SUB_PER_SEC with the remainder
+ * carried over from sub-block to sub-block, so that LOUDNESS_SUB_PER_SEC
+ * sub-blocks are exactly one second (11025 Hz: 1102, 1103, 1102, ...)
+ *
+ * \param sub   Index of the sub-block, from 0
+ *
+ * \return      Number of samples per channel in the sub-block
+ */
+static uint32_t s_loudness_sub_len(const uint32_t freq, const uint64_t sub);
+
+/*
+ * Measuring len samples of channel ch, called by s_convert_output() on the
+ * synthesis output it just converted, while it is still in cache
+ *
+ * Channels are expected in step, a channel may run ahead of the others by
+ * less than LOUDNESS_SUB_RING - LOUDNESS_SUB_PER_ST sub-blocks
+ */
+static void s_loudness_process(loudness_t *loudness,
+                               const float *src,
+                               const uint32_t len,
+                               const uint8_t ch);
+
+/*
+ * Adding the blocks that end with the sub-blocks every channel completed to
+ * the histograms
+ */
+static void s_loudness_blocks(loudness_t *loudness);
+
+/*
+ * \return  Histogram bin of a mean square, LOUDNESS_HIST_LEN if it is below
+ *          LOUDNESS_GATE_ABS
+ */
+static uint32_t s_loudness_bin(const double energy);
+
+/*
+ * Results of the samples measured so far, it can be called at any time
+ *
+ * \return  MP3LITE_OK, or MP3LITE_NEED_MORE_DATA if no gating block is above
+ *          the absolute gate (less than 400 ms or silence)
+ */
+static int s_loudness_result(const loudness_t *loudness,
+                             loudness_result_t *result);
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for loudness measurement                                      *
+ *                                                                           *
+ *****************************************************************************/
+
+static double s_db10(const double x)
+{
+    assert(x > 0.0);
+
+    /* x = m * 2^e with m in [1, 2) */
+    uint64_t bits = 0;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t e = (int32_t) ((bits >> 52) & 0x7FFu) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFu) | 0x3FF0000000000000u;
+    double m = 0.0;
+    memcpy(&m, &bits, sizeof(m));
+
+    /* ln(m) = 2 * atanh(y), y = (m - 1) / (m + 1) in [0, 1/3) */
+    const double y = (m - 1.0) / (m + 1.0);
+    const double y2 = y * y;
+    double term = y;
+    double ln_m = 0.0;
+    for (uint32_t n = 1; n < 20u; n += 2u)
+    {
+        ln_m += term / (double) n;
+        term *= y2;
+    }
+
+    /* 10 / ln(10) and 10 * log10(2) */
+    return (2.0 * ln_m * 4.342944819032518) + ((double) e * 3.010299956639812);
+}
+
+
+#if defined (MP3LITE_TEST)
+
+static const double *s_k_weighting(const uint32_t freq)
+{
+    /* BS.1770-4 filters (the 48000 Hz set of the standard), bilinear */
+    /* transform of the analog prototypes at each frequency              */
+    static const uint32_t s_k_freq[9] = {
+        44100u, 48000u, 32000u, 22050u, 24000u, 16000u, 11025u, 12000u, 8000u
+    };
+    static const double s_k_coef[9][7] = {
+        {1.530841230e+00, -2.650979995e+00, 1.169079080e+00,
+         -1.663655113e+00, 7.125954281e-01, -1.989169674e+00, 9.891990358e-01},
+        {1.535124860e+00, -2.691696189e+00, 1.198392811e+00,
+         -1.690659293e+00, 7.324807742e-01, -1.990047455e+00, 9.900722504e-01},
+        {1.511177900e+00, -2.464889413e+00, 1.041633274e+00,
+         -1.539045096e+00, 6.269668560e-01, -1.985089669e+00, 9.851453207e-01},
+        {1.479825351e+00, -2.170728613e+00, 8.608424847e-01,
+         -1.338305336e+00, 5.082445589e-01, -1.978397603e+00, 9.785144195e-01},
+        {1.487900221e+00, -2.246205468e+00, 9.049091232e-01,
+         -1.390234605e+00, 5.368384813e-01, -1.980144126e+00, 9.802428179e-01},
+        {1.443295223e+00, -1.831575381e+00, 6.816587574e-01,
+         -1.101533769e+00, 3.949123687e-01, -1.970289528e+00, 9.705104905e-01},
+        {1.386536193e+00, -1.311513920e+00, 4.638083084e-01,
+         -7.281015380e-01, 2.669321195e-01, -1.957025731e+00, 9.574880195e-01},
+        {1.401016386e+00, -1.443431420e+00, 5.127251914e-01,
+         -8.239804406e-01, 2.942905983e-01, -1.960483180e+00, 9.608740755e-01},
+        {1.321623569e+00, -7.262554913e-01, 2.981262460e-01,
+         -2.933807824e-01, 1.868751060e-01, -1.941013343e+00, 9.418843042e-01}
+    };
+
+    for (uint32_t i = 0; i < 9u; ++i)
+    {
+        if (s_k_freq[i] == freq)
+        {
+            return s_k_coef[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static void s_loudness_init(loudness_t *loudness)
+{
+    assert(loudness);
+
+    memset(loudness, 0, sizeof(loudness_t));
+}
+
+
+static void s_loudness_set_format(loudness_t *loudness,
+                                  const uint32_t freq,
+                                  const uint8_t nch)
+{
+    assert(loudness && (nch > 0u) && (nch <= NCH_MAX));
+
+    if ((loudness->freq == freq) && (loudness->nch == nch))
+    {
+        return;
+    }
+
+    loudness->freq = freq;
+    loudness->nch = nch;
+    loudness->k_coef = s_k_weighting(freq);
+    memset(loudness->k_state, 0, sizeof(loudness->k_state));
+    memset(loudness->sub_count, 0, sizeof(loudness->sub_count));
+    memset(loudness->sub_acc, 0, sizeof(loudness->sub_acc));
+    memset(loudness->nsub, 0, sizeof(loudness->nsub));
+    loudness->nsub_all = 0;
+    memset(loudness->tp_buf, 0, sizeof(loudness->tp_buf));
+    memset(loudness->tp_pos, 0, sizeof(loudness->tp_pos));
+
+    for (uint8_t ch = 0; ch < NCH_MAX; ++ch)
+    {
+        loudness->sub_len[ch] = s_loudness_sub_len(freq, 0);
+    }
+}
+
+
+static uint32_t s_loudness_sub_len(const uint32_t freq, const uint64_t sub)
+{
+    const uint64_t start = (sub * freq) / LOUDNESS_SUB_PER_SEC;
+    const uint64_t end = ((sub + 1u) * freq) / LOUDNESS_SUB_PER_SEC;
+
+    return (uint32_t) (end - start);
+}
+
+
+static void s_loudness_process(loudness_t *loudness,
+                               const float *src,
+                               const uint32_t len,
+                               const uint8_t ch)
+{
+    assert(loudness && src && (ch < NCH_MAX));
+
+    /* 4x oversampling phases 1 to 3 of the 48 taps windowed sinc, a filter */
+    /* of its own, not the one of BS.1770-4 Annex 2                         */
+    static const float s_tp_coef[TRUE_PEAK_PHASES][TRUE_PEAK_TAPS] = {
+        {-6.072863800e-05f, 2.086005593e-03f, -1.032750505e-02f,
+         3.338777622e-02f, -9.049110527e-02f, 2.816103163e-01f,
+         8.938803894e-01f, -1.507597507e-01f, 5.548871098e-02f,
+         -1.921291072e-02f, 5.025878192e-03f, -6.270763120e-04f},
+        {-3.656163282e-04f, 4.698854947e-03f, -2.012156102e-02f,
+         6.111506690e-02f, -1.641083815e-01f, 6.187816370e-01f,
+         6.187816370e-01f, -1.641083815e-01f, 6.111506690e-02f,
+         -2.012156102e-02f, 4.698854947e-03f, -3.656163282e-04f},
+        {-6.270763120e-04f, 5.025878192e-03f, -1.921291072e-02f,
+         5.548871098e-02f, -1.507597507e-01f, 8.938803894e-01f,
+         2.816103163e-01f, -9.049110527e-02f, 3.338777622e-02f,
+         -1.032750505e-02f, 2.086005593e-03f, -6.072863800e-05f}
+    };
+
+    const double *k = loudness->k_coef;
+    if (!k || (ch >= loudness->nch))
+    {
+        return;
+    }
+
+    double *z = &loudness->k_state[ch * 4u];
+    double acc = loudness->sub_acc[ch];
+    uint32_t count = loudness->sub_count[ch];
+    float *tp_buf = &loudness->tp_buf[ch * 2u * TRUE_PEAK_TAPS];
+    uint32_t tp_pos = loudness->tp_pos[ch];
+    float sample_peak = loudness->sample_peak;
+    float true_peak = loudness->true_peak;
+
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        const double x = (double) src[i];
+
+        /* High shelf then high pass, transposed direct form II */
+        const double y_0 = (k[0] * x) + z[0];
+        z[0] = (k[1] * x) - (k[3] * y_0) + z[1];
+        z[1] = (k[2] * x) - (k[4] * y_0);
+
+        const double y_1 = y_0 + z[2];
+        z[2] = (-2.0 * y_0) - (k[5] * y_1) + z[3];
+        z[3] = y_0 - (k[6] * y_1);
+
+        acc += y_1 * y_1;
+        if (++count == loudness->sub_len[ch])
+        {
+            uint64_t sub = loudness->nsub[ch]++;
+            loudness->sub_energy[(ch * LOUDNESS_SUB_RING) +
+                                 (uint32_t) (sub % LOUDNESS_SUB_RING)] =
+                acc / (double) count;
+            loudness->sub_len[ch] = s_loudness_sub_len(loudness->freq,
+                                                       sub + 1u);
+            acc = 0.0;
+            count = 0;
+        }
+
+        /* The window of the last TRUE_PEAK_TAPS samples, oldest first */
+        tp_buf[tp_pos] = src[i];
+        tp_buf[tp_pos + TRUE_PEAK_TAPS] = src[i];
+        tp_pos = (tp_pos + 1u) % TRUE_PEAK_TAPS;
+        const float *window = &tp_buf[tp_pos];
+
+        float a = (src[i] < 0.0f) ? -src[i] : src[i];
+        sample_peak = (a > sample_peak) ? a : sample_peak;
+        true_peak = (a > true_peak) ? a : true_peak;
+
+        for (uint32_t p = 0; p < TRUE_PEAK_PHASES; ++p)
+        {
+            float y = 0.0f;
+            for (uint32_t j = 0; j < TRUE_PEAK_TAPS; ++j)
+            {
+                y += window[j] * s_tp_coef[p][j];
+            }
+            y = (y < 0.0f) ? -y : y;
+            true_peak = (y > true_peak) ? y : true_peak;
+        }
+    }
+
+    loudness->sub_acc[ch] = acc;
+    loudness->sub_count[ch] = count;
+    loudness->tp_pos[ch] = tp_pos;
+    loudness->sample_peak = sample_peak;
+    loudness->true_peak = true_peak;
+
+    s_loudness_blocks(loudness);
+}
+
+
+static void s_loudness_blocks(loudness_t *loudness)
+{
+    assert(loudness);
+
+    uint64_t nsub = loudness->nsub[0];
+    for (uint8_t ch = 1; ch < loudness->nch; ++ch)
+    {
+        nsub = (loudness->nsub[ch] < nsub) ? loudness->nsub[ch] : nsub;
+    }
+
+    for (; loudness->nsub_all < nsub; ++loudness->nsub_all)
+    {
+        const uint64_t last = loudness->nsub_all;
+        double block = 0.0;
+        double st = 0.0;
+
+        /* Channel weights are 1.0 for mono and stereo */
+        for (uint32_t s = 0; (s < LOUDNESS_SUB_PER_ST) && (s <= last); ++s)
+        {
+            const uint32_t idx = (uint32_t) ((last - s) % LOUDNESS_SUB_RING);
+            double energy = 0.0;
+            for (uint8_t ch = 0; ch < loudness->nch; ++ch)
+            {
+                energy += loudness->sub_energy[(ch * LOUDNESS_SUB_RING) + idx];
+            }
+
+            block += (s < LOUDNESS_SUB_PER_BLOCK) ? energy : 0.0;
+            st += energy;
+        }
+
+        uint32_t bin = s_loudness_bin(block / LOUDNESS_SUB_PER_BLOCK);
+        if (((last + 1u) >= LOUDNESS_SUB_PER_BLOCK) &&
+            (bin < LOUDNESS_HIST_LEN))
+        {
+            ++loudness->block_count[bin];
+            loudness->block_energy[bin] += block / LOUDNESS_SUB_PER_BLOCK;
+        }
+
+        bin = s_loudness_bin(st / LOUDNESS_SUB_PER_ST);
+        if (((last + 1u) >= LOUDNESS_SUB_PER_ST) &&
+            (bin < LOUDNESS_HIST_LEN))
+        {
+            ++loudness->st_count[bin];
+            loudness->st_energy[bin] += st / LOUDNESS_SUB_PER_ST;
+        }
+    }
+}
+
+
+static uint32_t s_loudness_bin(const double energy)
+{
+    if (!(energy > 0.0))
+    {
+        return LOUDNESS_HIST_LEN;
+    }
+
+    const double lu = LOUDNESS_OFFSET + s_db10(energy) - LOUDNESS_GATE_ABS;
+    if (lu < 0.0)
+    {
+        return LOUDNESS_HIST_LEN;
+    }
+
+    const double bin = lu * LOUDNESS_BIN_PER_LU;
+
+    return (bin >= (double) (LOUDNESS_HIST_LEN - 1u)) ?
+           (LOUDNESS_HIST_LEN - 1u) : (uint32_t) bin;
+}
+
+
+static int s_loudness_result(const loudness_t *loudness,
+                             loudness_result_t *result)
+{
+    assert(loudness && result);
+
+    memset(result, 0, sizeof(loudness_result_t));
+
+    /* Integrated: mean of the blocks above the absolute gate, then of the */
+    /* blocks above the relative gate                                      */
+    double energy = 0.0;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < LOUDNESS_HIST_LEN; ++i)
+    {
+        energy += loudness->block_energy[i];
+        count += loudness->block_count[i];
+    }
+
+    if (count == 0u)
+    {
+        return MP3LITE_NEED_MORE_DATA;
+    }
+
+    uint32_t gate = s_loudness_bin(LOUDNESS_GATE_REL * energy /
+                                   (double) count);
+    gate = (gate < LOUDNESS_HIST_LEN) ? gate : 0;
+    energy = 0.0;
+    count = 0;
+    for (uint32_t i = gate; i < LOUDNESS_HIST_LEN; ++i)
+    {
+        energy += loudness->block_energy[i];
+        count += loudness->block_count[i];
+    }
+
+    result->integrated = LOUDNESS_OFFSET + s_db10(energy / (double) count);
+    result->replay_gain = LOUDNESS_REPLAY_GAIN_REF - result->integrated;
+    result->true_peak = 2.0 * s_db10((double) loudness->true_peak);
+    result->sample_peak = 2.0 * s_db10((double) loudness->sample_peak);
+
+    /* Range: 10th to 95th percentile of the short-term blocks above the */
+    /* relative gate                                                     */
+    energy = 0.0;
+    count = 0;
+    for (uint32_t i = 0; i < LOUDNESS_HIST_LEN; ++i)
+    {
+        energy += loudness->st_energy[i];
+        count += loudness->st_count[i];
+    }
+
+    if (count > 0u)
+    {
+        gate = s_loudness_bin(LOUDNESS_GATE_REL_LRA * energy /
+                              (double) count);
+        gate = (gate < LOUDNESS_HIST_LEN) ? gate : 0;
+        count = 0;
+        for (uint32_t i = gate; i < LOUDNESS_HIST_LEN; ++i)
+        {
+            count += loudness->st_count[i];
+        }
+
+        const uint64_t low = (count * 10u) / 100u;
+        const uint64_t high = (count * 95u) / 100u;
+        uint64_t seen = 0;
+        uint32_t low_bin = gate;
+        uint32_t high_bin = gate;
+        for (uint32_t i = gate; i < LOUDNESS_HIST_LEN; ++i)
+        {
+            low_bin = (seen <= low) ? i : low_bin;
+            high_bin = (seen <= high) ? i : high_bin;
+            seen += loudness->st_count[i];
+        }
+
+        result->range = (double) (high_bin - low_bin) / LOUDNESS_BIN_PER_LU;
+    }
+
+    return MP3LITE_OK;
+}
+
+#endif
+
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for output conversion                   *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Output sample formats (see mp3lite.h) */
+#define OUTPUT_FMT_S16  MP3LITE_FMT_S16
+#define OUTPUT_FMT_S24  MP3LITE_FMT_S24
+#define OUTPUT_FMT_F32  MP3LITE_FMT_F32
+
+/* Output sample layouts (see mp3lite.h) */
+#define OUTPUT_LAYOUT_INTERLEAVED   MP3LITE_LAYOUT_INTERLEAVED
+#define OUTPUT_LAYOUT_PLANAR        MP3LITE_LAYOUT_PLANAR
+
+/*
+ * Members
+ * -------
+ * fmt          OUTPUT_FMT_S16, OUTPUT_FMT_S24 or OUTPUT_FMT_F32
+ *
+ * layout       OUTPUT_LAYOUT_INTERLEAVED or OUTPUT_LAYOUT_PLANAR
+ *
+ * dither       If 1, TPDF dither of +-1 LSB is added before rounding
+ *              (OUTPUT_FMT_S16 only, ignored for the other formats)
+ *
+ * nch          Number of channels in the output buffer
+ *
+ * plane_len    Number of samples per channel in the output buffer,
+ *              i.e. the distance between two planes (planar layout only)
+ *
+ * loudness     Loudness meter fed with the converted samples, or NULL
+ */
+typedef struct {
+    uint8_t fmt;
+    uint8_t layout;
+    uint8_t dither;
+    uint8_t nch;
+    uint32_t plane_len;
+    loudness_t *loudness;
+} output_cfg_t;
+
+/* Until there is a synthesis, only the unit tests convert output */
+#if defined (MP3LITE_TEST)
+
+/*
+ * Converting the synthesis output of one channel to the requested sample
+ * format and writing it straight into the caller's buffer
+ *
+ * This function is meant to be called by the polyphase synthesis with the
+ * samples it just computed (e.g. the 32 samples of each subband slot), so the
+ * caller's buffer is touched exactly once and no intermediate PCM buffer is
+ * needed. The loops have no dependency between samples (including the dither,
+ * see s_tpdf_dither()) so they are vectorized by the compiler
+ *
+ * The synthesis does not exist yet, so only the unit tests build and call
+ * this function, and s_decoder_pull_frame() writes no PCM
+ *
+ * Integer formats saturate, and are rounded half away from zero
+ * OUTPUT_FMT_F32 is written as is, without clipping
+ *
+ * If cfg->loudness is set, src is measured right after the conversion while
+ * it is still in cache (see s_loudness_process())
+ *
+ * \param dest          Start of the caller's output buffer
+ *
+ * \param src           Synthesis output of channel ch, len samples
+ *
+ * \param len           Number of samples to convert
+ *
+ * \param ch            Current channel, starts at 0
+ *
+ * \param pos           Position of src[0] in the output buffer, in samples
+ *                      per channel
+ *
+ * \param cfg           Output format and layout
+ *
+ * \param dither_state  Dither sequence number, advanced by len if dither is
+ *                      enabled
+ */
+static void s_convert_output(void *dest,
+                             const float *src,
+                             const uint32_t len,
+                             const uint8_t ch,
+                             const uint32_t pos,
+                             const output_cfg_t *cfg,
+                             uint32_t *dither_state);
+
+/*
+ * TPDF (triangular probability density function) dither
+ *
+ * The noise is a hash of the sequence number instead of a pseudo random
+ * generator with a carried state, so each sample can be computed
+ * independently
+ *
+ * \param seq   Sequence number of the sample
+ *
+ * \return      Noise in LSB, in the range (-1.0, 1.0)
+ */
+static float s_tpdf_dither(const uint32_t seq);
+
+#endif
+
+/*
+ * \return  Size in bytes of one output sample in the output_cfg format
+ */
+static uint32_t s_output_sample_size(const output_cfg_t *output_cfg);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for output conversion                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+#if defined (MP3LITE_TEST)
+
+static float s_tpdf_dither(const uint32_t seq)
+{
+    /* Integer hash (lowbias32) */
+    uint32_t h = seq;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+
+    /* Sum of two uniform distributions is triangular */
+    int32_t u_0 = (int32_t) (h & 0xFFFFu);
+    int32_t u_1 = (int32_t) (h >> 16);
+
+    return (float) (u_0 - u_1) * (1.0f / 65536.0f);
+}
+
+
+static void s_convert_output(void *dest,
+                             const float *src,
+                             const uint32_t len,
+                             const uint8_t ch,
+                             const uint32_t pos,
+                             const output_cfg_t *cfg,
+                             uint32_t *dither_state)
+{
+    assert(dest && src && cfg && dither_state);
+    assert(ch < cfg->nch);
+
+    /* Distance between two consecutive samples of the same channel */
+    uint32_t stride = 1;
+    uint32_t start = 0;
+
+    if (cfg->layout == OUTPUT_LAYOUT_INTERLEAVED)
+    {
+        stride = cfg->nch;
+        start = (pos * cfg->nch) + ch;
+    }
+    else
+    {
+        assert((pos + len) <= cfg->plane_len);
+        stride = 1;
+        start = (ch * cfg->plane_len) + pos;
+    }
+
+    switch (cfg->fmt)
+    {
+        case OUTPUT_FMT_S16:
+        {
+            int16_t *out = (int16_t *) dest + start;
+            const uint32_t seq = *dither_state;
+            const float dither_gain = (cfg->dither) ? 1.0f : 0.0f;
+
+            for (uint32_t i = 0; i < len; ++i)
+            {
+                float v = (src[i] * 32768.0f) +
+                          (dither_gain * s_tpdf_dither(seq + i));
+                v = (v > 32767.0f) ? 32767.0f : v;
+                v = (v < -32768.0f) ? -32768.0f : v;
+                v += (v < 0.0f) ? -0.5f : 0.5f;
+                out[i * stride] = (int16_t) v;
+            }
+
+            if (cfg->dither)
+            {
+                *dither_state = seq + len;
+            }
+            break;
+        }
+
+        case OUTPUT_FMT_S24:
+        {
+            uint8_t *out = (uint8_t *) dest + (start * 3u);
+
+            for (uint32_t i = 0; i < len; ++i)
+            {
+                float v = src[i] * 8388608.0f;
+                v = (v > 8388607.0f) ? 8388607.0f : v;
+                v = (v < -8388608.0f) ? -8388608.0f : v;
+                v += (v < 0.0f) ? -0.5f : 0.5f;
+
+                uint32_t u = (uint32_t) (int32_t) v;
+                uint8_t *sample = &out[i * stride * 3u];
+#if !defined (MP3LITE_BIG_ENDIAN)
+                sample[0] = (uint8_t) (u & 0xFFu);
+                sample[1] = (uint8_t) ((u >> 8) & 0xFFu);
+                sample[2] = (uint8_t) ((u >> 16) & 0xFFu);
+#else
+                sample[0] = (uint8_t) ((u >> 16) & 0xFFu);
+                sample[1] = (uint8_t) ((u >> 8) & 0xFFu);
+                sample[2] = (uint8_t) (u & 0xFFu);
+#endif
+            }
+            break;
+        }
+
+        case OUTPUT_FMT_F32:
+        {
+            float *out = (float *) dest + start;
+
+            for (uint32_t i = 0; i < len; ++i)
+            {
+                out[i * stride] = src[i];
+            }
+            break;
+        }
+
+        default:
+            /* Invalid output format */
+            assert(0);
+            break;
+    }
+
+    if (cfg->loudness)
+    {
+        s_loudness_process(cfg->loudness, src, len, ch);
+    }
+}
+
+#endif
+
+
+static uint32_t s_output_sample_size(const output_cfg_t *output_cfg)
+{
+    assert(output_cfg);
+
+    uint32_t size = 0;
+
+    switch (output_cfg->fmt)
+    {
+        case OUTPUT_FMT_S16:
+            size = 2;
+            break;
+        case OUTPUT_FMT_S24:
+            size = 3;
+            break;
+        case OUTPUT_FMT_F32:
+            size = 4;
+            break;
+        default:
+            size = 0;
+            break;
+    }
+
+    return size;
+}
+
+#endif
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Function prototypes for the frame scanner                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Frame header length in bytes */
+#define HEADER_LEN 4u
+
+/* CRC length in bytes, if the frame is protected */
+#define CRC_LEN 2u
+
+/* Maximum frame length in bytes (320 kbits/s, 32000 Hz, with padding) */
+#define FRAME_LEN_MAX 1441u
+
+/* Largest window scanned at once in a stream held in memory, in bytes */
+#define SCAN_WINDOW_LEN (64u * 1024u)
+
+/*
+ * Reading the frame header as it is stored in the bitstream,
+ * i.e. the input expected by s_decode_frame_header()
+ *
+ * \param bitstream_ptr     Pointer to the first byte of the header,
+ *                          4 bytes MUST be readable
+ */
+static uint32_t s_read_frame_header(const uint8_t *bitstream_ptr);
+
+/*
+ * Checking whether a frame that can be decoded starts at bitstream_ptr
+ *
+ * Free format (bitrate index 0) and the reserved emphasis are rejected on top
+ * of the errors reported by s_decode_frame_header()
+ *
+ * \param bitstream_ptr     Pointer to the first byte of the header,
+ *                          4 bytes MUST be readable
+ *
+ * \return                  true if the header is valid
+ */
+static bool s_frame_header_valid(const uint8_t *bitstream_ptr,
+                                 header_info_t *header_info);
+
+/*
+ * Searching for the first valid frame header in buf
+ *
+ * A header found after skipping bytes is only taken if the header of the next
+ * frame is valid and of the same version, layer and sampling frequency, or is
+ * not in buf. This resynchronizes after corrupted or truncated frames without
+ * locking onto a false sync in the damaged bytes
+ *
+ * \param offset    If a header is found, the position of the header
+ *                  Otherwise, the number of bytes that can be dropped,
+ *                  the last 3 bytes are kept since they may be the start of
+ *                  a header that is not complete yet
+ *
+ * \return          true if a header is found, the rest of the frame may not
+ *                  be in buf yet
+ */
+static bool s_find_frame(const uint8_t *buf,
+                         const uint32_t len,
+                         uint32_t *offset,
+                         header_info_t *header_info);
+
+/*
+ * Checking the header of the frame after the one at buf[pos]
+ *
+ * \return  true if the next header is valid and of the same version, layer
+ *          and sampling frequency, or if it is not in buf
+ */
+static bool s_frame_chained(const uint8_t *buf,
+                            const uint32_t len,
+                            const uint32_t pos,
+                            const header_info_t *header_info);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for the frame scanner                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint32_t s_read_frame_header(const uint8_t *bitstream_ptr)
+{
+    assert(bitstream_ptr);
+
+    uint32_t frame_header = 0;
+    memcpy(&frame_header, bitstream_ptr, sizeof(frame_header));
+
+    return frame_header;
+}
+
+
+static bool s_frame_header_valid(const uint8_t *bitstream_ptr,
+                                 header_info_t *header_info)
+{
+    assert(bitstream_ptr && header_info);
+
+    /* Quick syncword check before decoding the whole header */
+    if ((bitstream_ptr[0] != 0xFFu) || ((bitstream_ptr[1] & 0xE0u) != 0xE0u))
+    {
+        return false;
+    }
+
+    uint8_t result = s_decode_frame_header(s_read_frame_header(bitstream_ptr),
+                                           header_info);
+
+    return ((result == 0u) &&
+            (header_info->bitrate != 0u) &&
+            (header_info->emphasis != 2u));
+}
+
+
+static bool s_find_frame(const uint8_t *buf,
+                         const uint32_t len,
+                         uint32_t *offset,
+                         header_info_t *header_info)
+{
+    assert(buf && offset && header_info);
+
+    bool found = false;
+    uint32_t i = 0;
+
+    while (((i + HEADER_LEN) <= len) && !found)
+    {
+        if (s_frame_header_valid(&buf[i], header_info))
+        {
+            found = (i == 0u) || s_frame_chained(buf, len, i, header_info);
+        }
+
+        i += (found) ? 0 : 1u;
+    }
+
+    *offset = i;
+
+    return found;
+}
+
+
+static bool s_frame_chained(const uint8_t *buf,
+                            const uint32_t len,
+                            const uint32_t pos,
+                            const header_info_t *header_info)
+{
+    assert(buf && header_info && (pos < len));
+
+    const uint32_t next = pos + s_frame_len(header_info);
+    header_info_t next_info;
+
+    if ((len < HEADER_LEN) || (next > (len - HEADER_LEN)))
+    {
+        return true;
+    }
+
+    return (s_frame_header_valid(&buf[next], &next_info) &&
+            (next_info.ver == header_info->ver) &&
+            (next_info.layer == header_info->layer) &&
+            (next_info.freq == header_info->freq));
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for skipping tags                       *
+ *                                                                           *
+ *****************************************************************************/
+
+/* ID3v2 header and footer length in bytes */
+#define ID3V2_HEADER_LEN 10u
+
+/* ID3v1 tag length in bytes */
+#define ID3V1_LEN 128u
+
+/* APEv2 header and footer length in bytes */
+#define APE_FOOTER_LEN 32u
+
+/*
+ * Length of the ID3v2 tag at buf, from its header alone
+ *
+ * \param buf   ID3V2_HEADER_LEN bytes MUST be readable
+ *
+ * \return      Tag length in bytes including the header and the footer, or
+ *              0 if no ID3v2 tag starts at buf
+ */
+static uint32_t s_id3v2_len(const uint8_t *buf);
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * \return  true if buf[0, len) is the start of an ID3v2 header, len is
+ *          smaller than ID3V2_HEADER_LEN
+ */
+static bool s_id3v2_partial(const uint8_t *buf, const uint32_t len);
+
+#endif
+
+/*
+ * Finding the audio of a stream held in memory, between the ID3v2 tags at
+ * the start and the APEv2/ID3v1 tags at the end
+ *
+ * \param start     Will be the offset of the first byte after the ID3v2 tags
+ *
+ * \param end       Will be the offset of the first byte of the trailing tags
+ *                  (size if there are none), never smaller than start
+ */
+static void s_stream_bounds(const uint8_t *data,
+                            const size_t size,
+                            size_t *start,
+                            size_t *end);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for skipping tags                                             *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint32_t s_id3v2_len(const uint8_t *buf)
+{
+    assert(buf);
+
+    /* "ID3", version, revision, flags, 4 bytes syncsafe size */
+    if ((buf[0] != 'I') || (buf[1] != 'D') || (buf[2] != '3') ||
+        (buf[3] == 0xFFu) || (buf[4] == 0xFFu) ||
+        ((buf[6] | buf[7] | buf[8] | buf[9]) & 0x80u))
+    {
+        return 0;
+    }
+
+    uint32_t size = ((uint32_t) buf[6] << 21) | ((uint32_t) buf[7] << 14) |
+                    ((uint32_t) buf[8] << 7) | (uint32_t) buf[9];
+
+    /* Footer present (ID3v2.4) */
+    uint32_t footer_len = (buf[5] & 0x10u) ? ID3V2_HEADER_LEN : 0;
+
+    return ID3V2_HEADER_LEN + size + footer_len;
+}
+
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+static bool s_id3v2_partial(const uint8_t *buf, const uint32_t len)
+{
+    assert(buf || (len == 0u));
+
+    static const uint8_t s_id3[3] = {'I', 'D', '3'};
+    uint32_t n = (len < 3u) ? len : 3u;
+
+    return (len < ID3V2_HEADER_LEN) && (memcmp(buf, s_id3, n) == 0);
+}
+
+#endif
+
+
+static void s_stream_bounds(const uint8_t *data,
+                            const size_t size,
+                            size_t *start,
+                            size_t *end)
+{
+    assert(data && start && end);
+
+    static const uint8_t s_ape[8] = {'A', 'P', 'E', 'T', 'A', 'G', 'E', 'X'};
+    size_t pos = 0;
+    size_t tag_len = 0;
+
+    /* ID3v2 tags, back to back, in O(1) each */
+    while (((size - pos) >= ID3V2_HEADER_LEN) &&
+           ((tag_len = s_id3v2_len(&data[pos])) > 0u))
+    {
+        pos = ((size - pos) < tag_len) ? size : (pos + tag_len);
+    }
+    *start = pos;
+    *end = size;
+
+    if (((*end - *start) >= ID3V1_LEN) &&
+        (memcmp(&data[*end - ID3V1_LEN], "TAG", 3) == 0))
+    {
+        *end -= ID3V1_LEN;
+    }
+
+    /* APEv2 footer: size (LE, without the header) at 12, flags at 20 */
+    if (((*end - *start) >= APE_FOOTER_LEN) &&
+        (memcmp(&data[*end - APE_FOOTER_LEN], s_ape, sizeof(s_ape)) == 0))
+    {
+        const uint8_t *footer = &data[*end - APE_FOOTER_LEN];
+        tag_len = (size_t) footer[12] | ((size_t) footer[13] << 8) |
+                  ((size_t) footer[14] << 16) | ((size_t) footer[15] << 24);
+        tag_len += (footer[23] & 0x80u) ? APE_FOOTER_LEN : 0;
+
+        *end = ((*end - *start) < tag_len) ? *start : (*end - tag_len);
+    }
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for gapless playback                    *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Samples per channel the decoder output lags behind the encoder input, on
+ * top of the encoder delay (the IMDCT overlap and the synthesis filterbank,
+ * 528 + 1 as counted by LAME)
+ */
+#define DECODER_DELAY 529u
+
+/* Xing/Info tag: "Xing" or "Info", then 4 bytes of flags */
+#define XING_HEADER_LEN 8u
+
+/* Optional fields of the Xing/Info tag, in this order */
+#define XING_FLAG_FRAMES    0x01u   /* 4 bytes, frames after this one */
+#define XING_FLAG_BYTES     0x02u   /* 4 bytes, stream length */
+#define XING_FLAG_TOC       0x04u   /* 100 bytes, seek table */
+#define XING_FLAG_QUALITY   0x08u   /* 4 bytes, VBR quality */
+
+#define XING_TOC_LEN 100u
+
+/*
+ * LAME tag after the Xing/Info tag: 9 bytes of encoder version, tag revision,
+ * lowpass, replay gain, flags and bitrate, then the encoder delay and padding
+ * in 3 bytes (12 bits each)
+ */
+#define LAME_DELAY_OFFSET 21u
+#define LAME_TAG_LEN 24u
+
+/*
+ * Reading the Xing/Info tag of a frame and the LAME tag after it
+ *
+ * Most encoders write a Xing/Info frame in front of the audio, its main data
+ * slot holds the tags instead of audio. The first decoded sample of the
+ * stream is enc_delay + DECODER_DELAY samples late, and the last frame is
+ * padded by enc_padding samples
+ *
+ * \param frame_ptr     Pointer to the frame header, the whole frame MUST be
+ *                      readable
+ *
+ * \param gapless       Will be the encoder delay and padding and the number
+ *                      of playable samples if the frame is a Xing/Info frame,
+ *                      the delay and padding are 0 without a LAME tag
+ *
+ * \return              true if the frame is a Xing/Info frame
+ */
+static bool s_decode_xing(const uint8_t *frame_ptr,
+                          const header_info_t *header_info,
+                          mp3lite_gapless_t *gapless);
+
+/*
+ * Looking for a Xing/Info frame as the first frame of data[start, end),
+ * within SCAN_WINDOW_LEN bytes of start
+ *
+ * \param xing_pos  Will be the offset of the Xing/Info frame if there is one
+ *
+ * \param gapless   See s_decode_xing(), zeroed if there is no Xing/Info frame
+ *
+ * \return          Offset of the first frame after the Xing/Info frame, or
+ *                  start if there is none
+ */
+static size_t s_find_xing(const uint8_t *data,
+                          const size_t start,
+                          const size_t end,
+                          size_t *xing_pos,
+                          mp3lite_gapless_t *gapless);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for gapless playback                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+static bool s_decode_xing(const uint8_t *frame_ptr,
+                          const header_info_t *header_info,
+                          mp3lite_gapless_t *gapless)
+{
+    assert(frame_ptr && header_info && gapless);
+
+    const uint32_t frame_len = s_frame_len(header_info);
+    const uint32_t crc_len = (header_info->protection) ? CRC_LEN : 0;
+    uint32_t pos = HEADER_LEN + crc_len + s_side_info_len(header_info);
+
+    /* The tag starts where the main data would */
+    if (((pos + XING_HEADER_LEN) > frame_len) ||
+        ((memcmp(&frame_ptr[pos], "Xing", 4) != 0) &&
+         (memcmp(&frame_ptr[pos], "Info", 4) != 0)))
+    {
+        return false;
+    }
+
+    const uint8_t *flags_ptr = &frame_ptr[pos + 4u];
+    const uint32_t flags = ((uint32_t) flags_ptr[0] << 24) |
+                           ((uint32_t) flags_ptr[1] << 16) |
+                           ((uint32_t) flags_ptr[2] << 8) |
+                           (uint32_t) flags_ptr[3];
+    uint64_t nframes = 0;
+    pos += XING_HEADER_LEN;
+
+    memset(gapless, 0, sizeof(mp3lite_gapless_t));
+
+    if ((flags & XING_FLAG_FRAMES) && ((pos + 4u) <= frame_len))
+    {
+        nframes = ((uint64_t) frame_ptr[pos] << 24) |
+                  ((uint64_t) frame_ptr[pos + 1u] << 16) |
+                  ((uint64_t) frame_ptr[pos + 2u] << 8) |
+                  (uint64_t) frame_ptr[pos + 3u];
+        pos += 4u;
+    }
+    pos += (flags & XING_FLAG_BYTES) ? 4u : 0;
+    pos += (flags & XING_FLAG_TOC) ? XING_TOC_LEN : 0;
+    pos += (flags & XING_FLAG_QUALITY) ? 4u : 0;
+
+    /* FFmpeg writes the same tag with its own encoder version */
+    if (((pos + LAME_TAG_LEN) <= frame_len) &&
+        ((memcmp(&frame_ptr[pos], "LAME", 4) == 0) ||
+         (memcmp(&frame_ptr[pos], "Lavf", 4) == 0) ||
+         (memcmp(&frame_ptr[pos], "Lavc", 4) == 0)))
+    {
+        const uint8_t *delay_ptr = &frame_ptr[pos + LAME_DELAY_OFFSET];
+        gapless->enc_delay = ((uint32_t) delay_ptr[0] << 4) |
+                             ((uint32_t) delay_ptr[1] >> 4);
+        gapless->enc_padding = ((uint32_t) (delay_ptr[1] & 0x0Fu) << 8) |
+                               (uint32_t) delay_ptr[2];
+        gapless->skip = gapless->enc_delay + DECODER_DELAY;
+    }
+
+    /* Unknown (0) without the number of frames */
+    const uint64_t total = nframes * s_samples_per_frame(header_info);
+    const uint64_t trim = (uint64_t) gapless->enc_delay + gapless->enc_padding;
+    gapless->nsamples = (total > trim) ? (total - trim) : 0;
+
+    return true;
+}
+
+
+static size_t s_find_xing(const uint8_t *data,
+                          const size_t start,
+                          const size_t end,
+                          size_t *xing_pos,
+                          mp3lite_gapless_t *gapless)
+{
+    assert(data && (start <= end) && xing_pos && gapless);
+
+    header_info_t header_info;
+    uint32_t offset = 0;
+    const size_t remaining = end - start;
+    const uint32_t len = (remaining < SCAN_WINDOW_LEN) ? (uint32_t) remaining :
+                                                         SCAN_WINDOW_LEN;
+
+    memset(gapless, 0, sizeof(mp3lite_gapless_t));
+
+    if (!s_find_frame(&data[start], len, &offset, &header_info) ||
+        ((len - offset) < s_frame_len(&header_info)) ||
+        !s_decode_xing(&data[start + offset], &header_info, gapless))
+    {
+        return start;
+    }
+
+    *xing_pos = start + offset;
+
+    return *xing_pos + s_frame_len(&header_info);
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for CRC-16                              *
+ *                                                                           *
+ *****************************************************************************/
+
+/* CRC-16 initial value (ISO/IEC 11172-3 2.4.3.1) */
+#define CRC_INIT 0xFFFFu
+
+/*
+ * CRC-16 with the polynomial x^16 + x^15 + x^2 + 1 (0x8005), most significant
+ * bit first, one table lookup per byte
+ *
+ * \param crc   CRC of the preceding bytes, CRC_INIT at the start
+ *
+ * \return      CRC of the preceding bytes and data[0, len)
+ */
+static uint16_t s_crc16(uint16_t crc, const uint8_t *data, const uint32_t len);
+
+/*
+ * Checking the CRC of a protected frame, it covers the last two bytes of the
+ * header and the side information
+ *
+ * \param frame_ptr     Pointer to the frame header, the header, CRC and side
+ *                      information MUST be readable
+ *
+ * \return              true if the CRC matches
+ */
+static bool s_frame_crc_ok(const uint8_t *frame_ptr,
+                           const header_info_t *header_info);
+
+/*
+ * Writing the CRC of a protected frame after its header or side information
+ * was rewritten
+ *
+ * \param frame_ptr     Pointer to the frame header, the header, CRC and side
+ *                      information MUST be writable
+ */
+static void s_frame_crc_write(uint8_t *frame_ptr,
+                              const header_info_t *header_info);
+
+/*
+ * \return  CRC of the last two bytes of the header and the side information
+ */
+static uint16_t s_frame_crc(const uint8_t *frame_ptr,
+                            const header_info_t *header_info);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for CRC-16                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint16_t s_crc16(uint16_t crc, const uint8_t *data, const uint32_t len)
+{
+    assert(data || (len == 0u));
+
+    /* s_crc_table[i]: CRC of the byte i shifted through the polynomial */
+    static const uint16_t s_crc_table[256] = {
+        0x0000u, 0x8005u, 0x800Fu, 0x000Au, 0x801Bu, 0x001Eu, 0x0014u, 0x8011u,
+        0x8033u, 0x0036u, 0x003Cu, 0x8039u, 0x0028u, 0x802Du, 0x8027u, 0x0022u,
+        0x8063u, 0x0066u, 0x006Cu, 0x8069u, 0x0078u, 0x807Du, 0x8077u, 0x0072u,
+        0x0050u, 0x8055u, 0x805Fu, 0x005Au, 0x804Bu, 0x004Eu, 0x0044u, 0x8041u,
+        0x80C3u, 0x00C6u, 0x00CCu, 0x80C9u, 0x00D8u, 0x80DDu, 0x80D7u, 0x00D2u,
+        0x00F0u, 0x80F5u, 0x80FFu, 0x00FAu, 0x80EBu, 0x00EEu, 0x00E4u, 0x80E1u,
+        0x00A0u, 0x80A5u, 0x80AFu, 0x00AAu, 0x80BBu, 0x00BEu, 0x00B4u, 0x80B1u,
+        0x8093u, 0x0096u, 0x009Cu, 0x8099u, 0x0088u, 0x808Du, 0x8087u, 0x0082u,
+        0x8183u, 0x0186u, 0x018Cu, 0x8189u, 0x0198u, 0x819Du, 0x8197u, 0x0192u,
+        0x01B0u, 0x81B5u, 0x81BFu, 0x01BAu, 0x81ABu, 0x01AEu, 0x01A4u, 0x81A1u,
+        0x01E0u, 0x81E5u, 0x81EFu, 0x01EAu, 0x81FBu, 0x01FEu, 0x01F4u, 0x81F1u,
+        0x81D3u, 0x01D6u, 0x01DCu, 0x81D9u, 0x01C8u, 0x81CDu, 0x81C7u, 0x01C2u,
+        0x0140u, 0x8145u, 0x814Fu, 0x014Au, 0x815Bu, 0x015Eu, 0x0154u, 0x8151u,
+        0x8173u, 0x0176u, 0x017Cu, 0x8179u, 0x0168u, 0x816Du, 0x8167u, 0x0162u,
+        0x8123u, 0x0126u, 0x012Cu, 0x8129u, 0x0138u, 0x813Du, 0x8137u, 0x0132u,
+        0x0110u, 0x8115u, 0x811Fu, 0x011Au, 0x810Bu, 0x010Eu, 0x0104u, 0x8101u,
+        0x8303u, 0x0306u, 0x030Cu, 0x8309u, 0x0318u, 0x831Du, 0x8317u, 0x0312u,
+        0x0330u, 0x8335u, 0x833Fu, 0x033Au, 0x832Bu, 0x032Eu, 0x0324u, 0x8321u,
+        0x0360u, 0x8365u, 0x836Fu, 0x036Au, 0x837Bu, 0x037Eu, 0x0374u, 0x8371u,
+        0x8353u, 0x0356u, 0x035Cu, 0x8359u, 0x0348u, 0x834Du, 0x8347u, 0x0342u,
+        0x03C0u, 0x83C5u, 0x83CFu, 0x03CAu, 0x83DBu, 0x03DEu, 0x03D4u, 0x83D1u,
+        0x83F3u, 0x03F6u, 0x03FCu, 0x83F9u, 0x03E8u, 0x83EDu, 0x83E7u, 0x03E2u,
+        0x83A3u, 0x03A6u, 0x03ACu, 0x83A9u, 0x03B8u, 0x83BDu, 0x83B7u, 0x03B2u,
+        0x0390u, 0x8395u, 0x839Fu, 0x039Au, 0x838Bu, 0x038Eu, 0x0384u, 0x8381u,
+        0x0280u, 0x8285u, 0x828Fu, 0x028Au, 0x829Bu, 0x029Eu, 0x0294u, 0x8291u,
+        0x82B3u, 0x02B6u, 0x02BCu, 0x82B9u, 0x02A8u, 0x82ADu, 0x82A7u, 0x02A2u,
+        0x82E3u, 0x02E6u, 0x02ECu, 0x82E9u, 0x02F8u, 0x82FDu, 0x82F7u, 0x02F2u,
+        0x02D0u, 0x82D5u, 0x82DFu, 0x02DAu, 0x82CBu, 0x02CEu, 0x02C4u, 0x82C1u,
+        0x8243u, 0x0246u, 0x024Cu, 0x8249u, 0x0258u, 0x825Du, 0x8257u, 0x0252u,
+        0x0270u, 0x8275u, 0x827Fu, 0x027Au, 0x826Bu, 0x026Eu, 0x0264u, 0x8261u,
+        0x0220u, 0x8225u, 0x822Fu, 0x022Au, 0x823Bu, 0x023Eu, 0x0234u, 0x8231u,
+        0x8213u, 0x0216u, 0x021Cu, 0x8219u, 0x0208u, 0x820Du, 0x8207u, 0x0202u
+    };
+
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        crc = (uint16_t) ((crc << 8) ^ s_crc_table[(crc >> 8) ^ data[i]]);
+    }
+
+    return crc;
+}
+
+
+static bool s_frame_crc_ok(const uint8_t *frame_ptr,
+                           const header_info_t *header_info)
+{
+    assert(frame_ptr && header_info && header_info->protection);
+
+    /* The CRC is stored big endian after the header */
+    uint16_t stored = (uint16_t) ((frame_ptr[HEADER_LEN] << 8) |
+                                  frame_ptr[HEADER_LEN + 1u]);
+
+    return (s_frame_crc(frame_ptr, header_info) == stored);
+}
+
+
+static void s_frame_crc_write(uint8_t *frame_ptr,
+                              const header_info_t *header_info)
+{
+    assert(frame_ptr && header_info && header_info->protection);
+
+    uint16_t crc = s_frame_crc(frame_ptr, header_info);
+    frame_ptr[HEADER_LEN] = (uint8_t) (crc >> 8);
+    frame_ptr[HEADER_LEN + 1u] = (uint8_t) crc;
+}
+
+
+static uint16_t s_frame_crc(const uint8_t *frame_ptr,
+                            const header_info_t *header_info)
+{
+    assert(frame_ptr && header_info);
+
+    uint16_t crc = s_crc16(CRC_INIT, &frame_ptr[2], HEADER_LEN - 2u);
+
+    return s_crc16(crc, &frame_ptr[HEADER_LEN + CRC_LEN],
+                   s_side_info_len(header_info));
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for the bit reservoir                   *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Maximum main_data_begin (9 bits for MPEG-1, 8 for MPEG-2/2.5), in bytes */
+#define MAIN_DATA_BEGIN_MAX     511u
+#define MAIN_DATA_BEGIN_MAX_LSF 255u
+
+/* Room for the look-back plus the main data slot of the current frame */
+#define RESERVOIR_SIZE (MAIN_DATA_BEGIN_MAX + FRAME_LEN_MAX)
+
+/*
+ * Smallest main data slot in bytes
+ * MPEG-1:      32 kbits/s, 48000 Hz, two channels, CRC: 96 - 4 - 2 - 32
+ * MPEG-2/2.5:  8 kbits/s, 24000 Hz, two channels, CRC: 24 - 4 - 2 - 17
+ */
+#define SLOT_LEN_MIN     58u
+#define SLOT_LEN_MIN_LSF 1u
+
+/*
+ * Number of main data slots that may hold the main data of one frame,
+ * the slots of the previous frames covering main_data_begin bytes plus
+ * the slot of the current frame
+ *
+ * The one byte slots of MPEG-2/2.5 need far more than MPEG-1
+ */
+#define MAIN_DATA_SEG_MAX \
+    (((MAIN_DATA_BEGIN_MAX_LSF + SLOT_LEN_MIN_LSF - 1u) / SLOT_LEN_MIN_LSF) + \
+     1u)
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * The main data of a frame, in order
+ *
+ * When the main data slots are copied into the reservoir, the main data is
+ * one segment. When decoding in place (see mp3lite_decoder_set_input()), the
+ * main data is read from the slots of the previous frames where they are, and
+ * each slot is a segment
+ *
+ * Members
+ * -------
+ * seg_ptr[i]   First byte of segment i
+ *
+ * seg_len[i]   Length of segment i in bytes
+ *
+ * nseg         Number of segments
+ *
+ * len          Total length in bytes
+ */
+typedef struct {
+    const uint8_t *seg_ptr[MAIN_DATA_SEG_MAX];
+    uint32_t seg_len[MAIN_DATA_SEG_MAX];
+    uint32_t nseg;
+    uint32_t len;
+} main_data_t;
+
+/*
+ * The main data of a frame may begin in the main data slot of the previous
+ * frames (up to MAIN_DATA_BEGIN_MAX bytes back), the bit reservoir keeps the
+ * main data slots of the previous frames back to back
+ *
+ * Members
+ * -------
+ * buf      Main data slots, the current frame is at the end
+ *
+ * len      Number of valid bytes in buf
+ */
+typedef struct {
+    uint8_t buf[RESERVOIR_SIZE];
+    uint32_t len;
+} reservoir_t;
+
+/*
+ * The main data slots of the previous frames when decoding in place, pointing
+ * into the caller's buffer, nothing is copied
+ *
+ * Members
+ * -------
+ * slot_ptr[idx]    First byte of the slot, idx = (head + i) % MAIN_DATA_SEG_MAX
+ *                  for the i-th slot, the oldest first
+ *
+ * slot_len[idx]    Length of the slot in bytes
+ *
+ * head             Index of the oldest slot
+ *
+ * count            Number of slots
+ */
+typedef struct {
+    const uint8_t *slot_ptr[MAIN_DATA_SEG_MAX];
+    uint32_t slot_len[MAIN_DATA_SEG_MAX];
+    uint32_t head;
+    uint32_t count;
+} slot_history_t;
+
+/*
+ * Appending (copying) the main data slot of the current frame to the
+ * reservoir and locating the main data of the current frame
+ *
+ * The slot is appended even if this function fails, so the next frames can
+ * use it
+ *
+ * \param slot              Main data slot of the current frame
+ *
+ * \param slot_len          Length of the slot in bytes, see
+ *                          s_frame_compressed_len()
+ *
+ * \param main_data_begin   From the side information of the current frame
+ *
+ * \param main_data         One segment, from the first byte of the main data
+ *                          to the end of the slot of the current frame,
+ *                          valid until the next call
+ *
+ * \return                  false if main_data_begin reaches before the
+ *                          first byte in the reservoir
+ */
+static bool s_reservoir_append(reservoir_t *reservoir,
+                               const uint8_t *slot,
+                               const uint32_t slot_len,
+                               const uint16_t main_data_begin,
+                               main_data_t *main_data);
+
+/*
+ * Same as s_reservoir_append(), but the slot is not copied, the main data
+ * segments point to the slots where they are
+ *
+ * \param slot  Main data slot of the current frame, MUST stay valid as long
+ *              as it can be referred by the next frames
+ */
+static bool s_slot_history_append(slot_history_t *history,
+                                  const uint8_t *slot,
+                                  const uint32_t slot_len,
+                                  const uint16_t main_data_begin,
+                                  main_data_t *main_data);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for the bit reservoir                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+static bool s_reservoir_append(reservoir_t *reservoir,
+                               const uint8_t *slot,
+                               const uint32_t slot_len,
+                               const uint16_t main_data_begin,
+                               main_data_t *main_data)
+{
+    assert(reservoir && slot && main_data);
+    assert(slot_len <= FRAME_LEN_MAX);
+    assert(main_data_begin <= MAIN_DATA_BEGIN_MAX);
+
+    /* Only MAIN_DATA_BEGIN_MAX bytes of the previous frames are needed */
+    if (reservoir->len > MAIN_DATA_BEGIN_MAX)
+    {
+        memmove(reservoir->buf,
+                &reservoir->buf[reservoir->len - MAIN_DATA_BEGIN_MAX],
+                MAIN_DATA_BEGIN_MAX);
+        reservoir->len = MAIN_DATA_BEGIN_MAX;
+    }
+
+    bool success = (main_data_begin <= reservoir->len);
+    uint32_t begin = (success) ? (reservoir->len - main_data_begin) : 0;
+
+    memcpy(&reservoir->buf[reservoir->len], slot, slot_len);
+    reservoir->len += slot_len;
+
+    main_data->seg_ptr[0] = &reservoir->buf[begin];
+    main_data->seg_len[0] = (success) ? (reservoir->len - begin) : 0;
+    main_data->nseg = (success) ? 1u : 0;
+    main_data->len = main_data->seg_len[0];
+
+    return success;
+}
+
+
+static bool s_slot_history_append(slot_history_t *history,
+                                  const uint8_t *slot,
+                                  const uint32_t slot_len,
+                                  const uint16_t main_data_begin,
+                                  main_data_t *main_data)
+{
+    assert(history && slot && main_data);
+    assert(main_data_begin <= MAIN_DATA_BEGIN_MAX);
+
+    /* Dropping the oldest slot if the history is full */
+    if (history->count == MAIN_DATA_SEG_MAX)
+    {
+        history->head = (history->head + 1u) % MAIN_DATA_SEG_MAX;
+        --history->count;
+    }
+
+    uint32_t cur = (history->head + history->count) % MAIN_DATA_SEG_MAX;
+    history->slot_ptr[cur] = slot;
+    history->slot_len[cur] = slot_len;
+    ++history->count;
+
+    /* Walking back from the previous slot until main_data_begin is covered */
+    uint32_t nprev = 0;
+    uint32_t prev_len = 0;
+    while ((prev_len < main_data_begin) && ((nprev + 1u) < history->count))
+    {
+        ++nprev;
+        uint32_t idx = (cur + MAIN_DATA_SEG_MAX - nprev) % MAIN_DATA_SEG_MAX;
+        prev_len += history->slot_len[idx];
+    }
+
+    main_data->nseg = 0;
+    main_data->len = 0;
+
+    if (prev_len < main_data_begin)
+    {
+        return false;
+    }
+
+    /* Oldest slot first, only its last bytes belong to this frame */
+    uint32_t skip = prev_len - main_data_begin;
+    for (uint32_t j = 0; j <= nprev; ++j)
+    {
+        uint32_t idx = (cur + MAIN_DATA_SEG_MAX - nprev + j) %
+                       MAIN_DATA_SEG_MAX;
+        uint32_t seg_len = history->slot_len[idx] - skip;
+
+        if (seg_len > 0u)
+        {
+            main_data->seg_ptr[main_data->nseg] = &history->slot_ptr[idx][skip];
+            main_data->seg_len[main_data->nseg] = seg_len;
+            ++main_data->nseg;
+            main_data->len += seg_len;
+        }
+        skip = 0;
+    }
+
+    return true;
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for error concealment                   *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Gain of the repeated spectrum from the second concealed granule (-6 dB) */
+#define CONCEAL_GAIN 0.5f
+
+/* Consecutive concealed granules after which the output is muted */
+#define CONCEAL_GRANULES_MAX 8u
+
+/*
+ * Turning the spectrum of the last granule into the spectrum of a concealed
+ * granule, in place
+ *
+ * The first concealed granule repeats the spectrum, the next ones fade it by
+ * CONCEAL_GAIN each, and it is muted after CONCEAL_GRANULES_MAX granules. The
+ * result is meant to go through the IMDCT and the synthesis like a decoded
+ * spectrum, so the overlap and the V vector stay consistent, once they exist
+ *
+ * \param xr            Spectrum of every channel
+ *
+ * \param len           Number of elements in xr
+ *
+ * \param nconcealed    Number of consecutive concealed granules, including
+ *                      this one
+ */
+static void s_conceal_spectrum(float *xr,
+                               const uint32_t len,
+                               const uint32_t nconcealed);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for error concealment                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+static void s_conceal_spectrum(float *xr,
+                               const uint32_t len,
+                               const uint32_t nconcealed)
+{
+    assert(xr && (nconcealed > 0u));
+
+    if (nconcealed > CONCEAL_GRANULES_MAX)
+    {
+        memset(xr, 0, len * sizeof(float));
+    }
+    else if (nconcealed > 1u)
+    {
+        for (uint32_t i = 0; i < len; ++i)
+        {
+            xr[i] *= CONCEAL_GAIN;
+        }
+    }
+}
+
+#endif
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for the streaming decoder               *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Input buffer size in bytes, holds a few frames */
+#define INPUT_BUF_SIZE (4u * FRAME_LEN_MAX)
+
+/* Length of the polyphase synthesis V vector per channel */
+#define SYNTH_V_LEN 1024u
+
+/* Read-ahead hinted to the kernel when decoding in place, in bytes */
+#define READAHEAD_LEN (1024u * 1024u)
+
+/* Bytes dropped by one pull while searching a frame before giving up */
+#define SYNC_SCAN_MAX SCAN_WINDOW_LEN
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * Members
+ * -------
+ * output_cfg       Output format and layout, output_cfg.nch and
+ *                  output_cfg.plane_len are set for each frame
+ *
+ * mono_output      true if stereo/joint stereo is downmixed to mono
+ *
+ * crc_policy       MP3LITE_CRC_SKIP, MP3LITE_CRC_VERIFY or MP3LITE_CRC_DROP
+ *
+ * conceal_b        true if damaged frames are concealed, see
+ *                  mp3lite_decoder_set_conceal()
+ *
+ * nconcealed       Number of consecutive concealed granules
+ *
+ * dither_state     See s_convert_output()
+ *
+ * header_info      Header of the last decoded frame
+ *
+ * side_info        Side information of the last decoded frame
+ *
+ * info_valid       true once a frame header has been decoded
+ *
+ * input            Fed bytes that are not pulled yet are in
+ *                  input[input_start, input_end)
+ *
+ * input_pos        Stream offset of the first unpulled byte
+ *
+ * map_ptr          Caller's buffer when decoding in place, NULL otherwise,
+ *                  see mp3lite_decoder_set_input()
+ *
+ * map_size         Size of the caller's buffer in bytes
+ *
+ * advise_pos       Offset in the caller's buffer up to which the read-ahead
+ *                  has been requested (MP3LITE_USE_MADVISE only)
+ *
+ * map_start        Offset of the audio in the caller's buffer, after the
+ *                  ID3v2 tags and the Xing/Info frame
+ *
+ * skip_len         Bytes of an ID3v2 tag left to drop from the fed input
+ *
+ * preroll_frames   Frames left to decode without output before the first
+ *                  frame of a chunk or of a seek, see
+ *                  mp3lite_decoder_set_chunk() and mp3lite_decoder_seek()
+ *
+ * skip_samples     Samples per channel left to drop from the output before
+ *                  the target of a seek or the end of the encoder and
+ *                  decoder delay
+ *
+ * samples_left     Samples per channel left to output before the encoder
+ *                  padding, UINT64_MAX if the end is not trimmed
+ *
+ * gapless          See mp3lite_decoder_gapless()
+ *
+ * xing_check_b     true until the first frame of fed input is pulled, it may
+ *                  be a Xing/Info frame
+ *
+ * reservoir        Bit reservoir, used when the input is fed
+ *
+ * history          Main data slots of the previous frames, used when
+ *                  decoding in place
+ *
+ * main_data        Main data of the last decoded frame
+ *
+ * xr               Scratch spectra of the current granule,
+ *                  idx = ch * GRANULE_LEN + frequency line
+ *
+ * overlap          Second half of the IMDCT output of the previous granule,
+ *                  idx = ch * GRANULE_LEN + i
+ *
+ * synth_v          Polyphase synthesis V vector (ISO/IEC 11172-3 Annex A),
+ *                  idx = ch * SYNTH_V_LEN + i
+ *
+ * synth_v_offset   Start of the V vector ring for each channel
+ *
+ * The whole state lives in this struct, the decoder never allocates memory,
+ * see mp3lite_decoder_init()
+ */
+struct mp3lite_decoder {
+    output_cfg_t output_cfg;
+    bool mono_output;
+    uint8_t crc_policy;
+    bool conceal_b;
+    uint32_t nconcealed;
+    uint32_t dither_state;
+
+    header_info_t header_info;
+    side_info_t side_info;
+    bool info_valid;
+
+    uint8_t input[INPUT_BUF_SIZE];
+    uint32_t input_start;
+    uint32_t input_end;
+    uint64_t input_pos;
+
+    const uint8_t *map_ptr;
+    size_t map_size;
+    size_t advise_pos;
+    size_t map_start;
+    uint32_t skip_len;
+    uint32_t preroll_frames;
+    uint32_t skip_samples;
+    uint64_t samples_left;
+    mp3lite_gapless_t gapless;
+    bool xing_check_b;
+
+    reservoir_t reservoir;
+    slot_history_t history;
+    main_data_t main_data;
+
+    float xr[NCH_MAX * GRANULE_LEN];
+    float overlap[NCH_MAX * GRANULE_LEN];
+    float synth_v[NCH_MAX * SYNTH_V_LEN];
+    uint32_t synth_v_offset[NCH_MAX];
+};
+
+/* Used for finding the alignment of struct mp3lite_decoder in C99 */
+typedef struct {
+    char c;
+    struct mp3lite_decoder dec;
+} decoder_align_t;
+
+/* Compile time checks, the array length is negative if the check fails */
+typedef char decoder_size_check_t[
+    (sizeof(struct mp3lite_decoder) <= MP3LITE_DECODER_SIZE) ? 1 : -1];
+typedef char decoder_align_check_t[
+    (offsetof(decoder_align_t, dec) <= MP3LITE_DECODER_ALIGN) ? 1 : -1];
+typedef char decoder_cache_line_check_t[
+    ((MP3LITE_DECODER_SIZE % 64u) == 0u) ? 1 : -1];
+
+/*
+ * Converting header_info_t to the public mp3lite_stream_info_t
+ */
+static void s_stream_info(const header_info_t *header_info,
+                          mp3lite_stream_info_t *info);
+
+/*
+ * \param ptr   Will point to the first unpulled byte, either in the input
+ *              buffer or in the caller's buffer when decoding in place
+ *
+ * \return      Number of unpulled bytes that can be scanned from ptr
+ */
+static uint32_t s_decoder_unpulled(const mp3lite_decoder_t *dec,
+                                   const uint8_t **ptr);
+
+/*
+ * Dropping len bytes from the beginning of the unpulled input
+ */
+static void s_decoder_consume(mp3lite_decoder_t *dec, const uint32_t len);
+
+/*
+ * Decoding in place from data[start, end)
+ */
+static void s_decoder_map(mp3lite_decoder_t *dec,
+                          const uint8_t *data,
+                          const size_t start,
+                          const size_t end);
+
+/*
+ * Pulling the next frame, see mp3lite_decoder_pull(), without the pre-roll
+ */
+static int s_decoder_pull_frame(mp3lite_decoder_t *dec,
+                                void *pcm,
+                                const size_t pcm_size,
+                                mp3lite_frame_t *frame);
+
+/*
+ * Trimming the delay and the padding of the stream from the output, from the
+ * first frame after the Xing/Info frame
+ */
+static void s_decoder_gapless_start(mp3lite_decoder_t *dec,
+                                    const mp3lite_gapless_t *gapless);
+
+/*
+ * Asking the kernel to read ahead of the current position in the caller's
+ * buffer, a no-op unless MP3LITE_USE_MADVISE is defined
+ *
+ * \param force     Issue the hint even if the current window is not used up
+ */
+static void s_decoder_advise(mp3lite_decoder_t *dec, const bool force);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for the streaming decoder                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static void s_stream_info(const header_info_t *header_info,
+                          mp3lite_stream_info_t *info)
+{
+    assert(header_info && info);
+
+    info->ver = header_info->ver;
+    info->layer = header_info->layer;
+    info->mode = header_info->mode;
+    info->mode_ext = header_info->mode_ext;
+    info->nch = (header_info->mode == 3u) ? 1u : 2u;
+    info->protection = header_info->protection;
+    info->emphasis = header_info->emphasis;
+    info->bitrate = header_info->bitrate;
+    info->freq = header_info->freq;
+    info->frame_len = s_frame_len(header_info);
+    info->samples_per_frame = s_samples_per_frame(header_info);
+}
+
+
+static uint32_t s_decoder_unpulled(const mp3lite_decoder_t *dec,
+                                   const uint8_t **ptr)
+{
+    assert(dec && ptr);
+
+    uint32_t len = 0;
+
+    if (dec->map_ptr)
+    {
+        size_t remaining = dec->map_size - (size_t) dec->input_pos;
+        *ptr = &dec->map_ptr[dec->input_pos];
+        len = (remaining < SCAN_WINDOW_LEN) ? (uint32_t) remaining :
+                                              SCAN_WINDOW_LEN;
+    }
+    else
+    {
+        *ptr = &dec->input[dec->input_start];
+        len = dec->input_end - dec->input_start;
+    }
+
+    return len;
+}
+
+
+static void s_decoder_consume(mp3lite_decoder_t *dec, const uint32_t len)
+{
+    assert(dec);
+
+    dec->input_pos += len;
+
+    if (dec->map_ptr)
+    {
+        assert(dec->input_pos <= dec->map_size);
+        s_decoder_advise(dec, false);
+    }
+    else
+    {
+        assert(len <= (dec->input_end - dec->input_start));
+        dec->input_start += len;
+
+        if (dec->input_start == dec->input_end)
+        {
+            dec->input_start = 0;
+            dec->input_end = 0;
+        }
+    }
+}
+
+
+static void s_decoder_map(mp3lite_decoder_t *dec,
+                          const uint8_t *data,
+                          const size_t start,
+                          const size_t end)
+{
+    assert(dec && (start <= end));
+
+    mp3lite_decoder_flush(dec);
+
+    dec->input_pos = start;
+    dec->map_ptr = data;
+    dec->map_size = (data) ? end : 0;
+    dec->advise_pos = start;
+
+#if defined (MP3LITE_USE_MADVISE)
+    if (data && (start < end))
+    {
+        uintptr_t page_mask = (uintptr_t) sysconf(_SC_PAGESIZE) - 1u;
+        uintptr_t addr = (uintptr_t) &data[start];
+        uintptr_t addr_aligned = addr & ~page_mask;
+
+        (void) madvise((void *) addr_aligned,
+                       (end - start) + (size_t) (addr - addr_aligned),
+                       MADV_SEQUENTIAL);
+        s_decoder_advise(dec, true);
+    }
+#endif
+}
+
+
+static void s_decoder_advise(mp3lite_decoder_t *dec, const bool force)
+{
+    assert(dec && dec->map_ptr);
+
+#if defined (MP3LITE_USE_MADVISE)
+    /* Requesting the next window when half of the current one is used */
+    size_t pos = (size_t) dec->input_pos;
+    if ((force || ((pos + (READAHEAD_LEN / 2u)) >= dec->advise_pos)) &&
+        (dec->advise_pos < dec->map_size))
+    {
+        size_t start = (pos > dec->advise_pos) ? pos : dec->advise_pos;
+        size_t end = start + READAHEAD_LEN;
+        end = (end > dec->map_size) ? dec->map_size : end;
+
+        /* madvise() needs a page aligned address */
+        uintptr_t page_mask = (uintptr_t) sysconf(_SC_PAGESIZE) - 1u;
+        uintptr_t addr = (uintptr_t) &dec->map_ptr[start];
+        uintptr_t addr_aligned = addr & ~page_mask;
+
+        /* Only hints, failures are ignored */
+        (void) madvise((void *) addr_aligned,
+                       (end - start) + (size_t) (addr - addr_aligned),
+                       MADV_WILLNEED);
+
+        dec->advise_pos = end;
+    }
+#else
+    (void) dec;
+    (void) force;
+#endif
+}
+
+
+size_t mp3lite_decoder_size(void)
+{
+    return sizeof(mp3lite_decoder_t);
+}
+
+
+mp3lite_decoder_t *mp3lite_decoder_init(void *mem, const size_t size)
+{
+    if (!mem || (size < sizeof(mp3lite_decoder_t)) ||
+        (((uintptr_t) mem % MP3LITE_DECODER_ALIGN) != 0u))
+    {
+        return NULL;
+    }
+
+    mp3lite_decoder_t *dec = mem;
+    memset(dec, 0, sizeof(mp3lite_decoder_t));
+
+    dec->output_cfg.fmt = OUTPUT_FMT_S16;
+    dec->output_cfg.layout = OUTPUT_LAYOUT_INTERLEAVED;
+    dec->output_cfg.dither = 0;
+    dec->mono_output = false;
+    dec->crc_policy = MP3LITE_CRC_SKIP;
+    dec->samples_left = UINT64_MAX;
+    dec->xing_check_b = true;
+
+    return dec;
+}
+
+
+int mp3lite_decoder_set_output(mp3lite_decoder_t *dec,
+                               const mp3lite_output_t *output)
+{
+    if (!dec || !output ||
+        (output->fmt > OUTPUT_FMT_F32) ||
+        (output->layout > OUTPUT_LAYOUT_PLANAR) ||
+        (output->dither > 1u) || (output->mono > 1u))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    dec->output_cfg.fmt = output->fmt;
+    dec->output_cfg.layout = output->layout;
+    dec->output_cfg.dither = output->dither;
+    dec->mono_output = (output->mono == 1u);
+
+    return MP3LITE_OK;
+}
+
+
+int mp3lite_decoder_set_crc(mp3lite_decoder_t *dec, const uint8_t policy)
+{
+    if (!dec || (policy > MP3LITE_CRC_DROP))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    dec->crc_policy = policy;
+
+    return MP3LITE_OK;
+}
+
+
+int mp3lite_decoder_set_conceal(mp3lite_decoder_t *dec,
+                                const uint8_t conceal)
+{
+    if (!dec || (conceal > 1u))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    dec->conceal_b = (conceal == 1u);
+
+    return MP3LITE_OK;
+}
+
+
+int mp3lite_decoder_set_input(mp3lite_decoder_t *dec,
+                              const uint8_t *data,
+                              const size_t size)
+{
+    if (!dec || (!data && (size > 0u)))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    /* Tags are skipped without scanning them for frames */
+    size_t start = 0;
+    size_t end = size;
+    size_t xing_pos = 0;
+    mp3lite_gapless_t gapless;
+    memset(&gapless, 0, sizeof(gapless));
+
+    if (data)
+    {
+        s_stream_bounds(data, size, &start, &end);
+        start = s_find_xing(data, start, end, &xing_pos, &gapless);
+    }
+
+    s_decoder_map(dec, data, start, end);
+    dec->map_start = start;
+    s_decoder_gapless_start(dec, &gapless);
+
+    /* In place, the Xing/Info frame is already read */
+    dec->xing_check_b = !data;
+
+    return MP3LITE_OK;
+}
+
+
+int mp3lite_decoder_set_chunk(mp3lite_decoder_t *dec,
+                              const uint8_t *data,
+                              const size_t size,
+                              const mp3lite_chunk_t *chunk)
+{
+    if (!dec || !data || !chunk ||
+        (chunk->preroll_offset > chunk->offset) ||
+        (chunk->offset > chunk->end) || (chunk->end > size))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+    mp3lite_gapless_t gapless;
+    s_stream_bounds(data, size, &start, &end);
+    const size_t audio_start = s_find_xing(data, start, end, &xing_pos,
+                                           &gapless);
+
+    size_t preroll_offset = chunk->preroll_offset;
+    uint32_t preroll_frames = chunk->preroll_frames;
+    const bool first_b = (audio_start > start) &&
+                         (chunk->offset <= audio_start);
+
+    /*
+     * Chunks from mp3lite_split() start after the Xing/Info frame, it is left
+     * out of any other chunk or pre-roll holding it
+     */
+    if ((audio_start > start) && (preroll_offset <= xing_pos) &&
+        (xing_pos < chunk->end))
+    {
+        preroll_frames -= (!first_b && (preroll_frames > 0u)) ? 1u : 0u;
+        preroll_offset = audio_start;
+    }
+
+    s_decoder_map(dec, data, preroll_offset, chunk->end);
+    dec->map_start = audio_start;
+    dec->preroll_frames = preroll_frames;
+    dec->xing_check_b = false;
+
+    /* Only the first chunk starts at the delay */
+    dec->gapless = gapless;
+    if (first_b)
+    {
+        s_decoder_gapless_start(dec, &gapless);
+    }
+
+    return MP3LITE_OK;
+}
+
+
+size_t mp3lite_decoder_feed(mp3lite_decoder_t *dec,
+                            const uint8_t *data,
+                            const size_t size)
+{
+    if (!dec || !data || dec->map_ptr)
+    {
+        return 0;
+    }
+
+    /* The rest of an ID3v2 tag is dropped as it comes, nothing is scanned */
+    const size_t dropped = (size < dec->skip_len) ? size : dec->skip_len;
+    const size_t rest = size - dropped;
+    dec->skip_len -= (uint32_t) dropped;
+    dec->input_pos += dropped;
+
+    /* Moving the unpulled bytes to the front to make room */
+    if ((dec->input_start > 0) &&
+        ((INPUT_BUF_SIZE - dec->input_end) < rest))
+    {
+        uint32_t len = dec->input_end - dec->input_start;
+        memmove(dec->input, &dec->input[dec->input_start], len);
+        dec->input_start = 0;
+        dec->input_end = len;
+    }
+
+    size_t accepted = INPUT_BUF_SIZE - dec->input_end;
+    accepted = (rest < accepted) ? rest : accepted;
+
+    memcpy(&dec->input[dec->input_end], &data[dropped], accepted);
+    dec->input_end += (uint32_t) accepted;
+
+    return dropped + accepted;
+}
+
+
+int mp3lite_decoder_pull(mp3lite_decoder_t *dec,
+                         void *pcm,
+                         const size_t pcm_size,
+                         mp3lite_frame_t *frame)
+{
+    if (!dec)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    int result = MP3LITE_OK;
+
+    /* Pre-roll frames only fill the reservoir and warm up the synthesis */
+    while ((dec->preroll_frames > 0u) && (result != MP3LITE_NEED_MORE_DATA))
+    {
+        result = s_decoder_pull_frame(dec, NULL, 0, NULL);
+        dec->preroll_frames -= ((result != MP3LITE_NEED_MORE_DATA) &&
+                                (result != MP3LITE_ERR_SYNC)) ? 1u : 0u;
+    }
+
+    if (result != MP3LITE_NEED_MORE_DATA)
+    {
+        result = s_decoder_pull_frame(dec, pcm, pcm_size, frame);
+    }
+
+    return result;
+}
+
+
+static int s_decoder_pull_frame(mp3lite_decoder_t *dec,
+                                void *pcm,
+                                const size_t pcm_size,
+                                mp3lite_frame_t *frame)
+{
+    assert(dec);
+
+    header_info_t header_info;
+    const uint8_t *frame_ptr = NULL;
+    uint32_t len = 0;
+    uint32_t offset = 0;
+    uint32_t dropped = 0;
+    bool found = false;
+
+    /* An ID3v2 tag before the first frame of fed input is skipped whole */
+    if (!dec->map_ptr && !dec->info_valid)
+    {
+        len = s_decoder_unpulled(dec, &frame_ptr);
+        if (s_id3v2_partial(frame_ptr, len))
+        {
+            return MP3LITE_NEED_MORE_DATA;
+        }
+
+        uint32_t tag_len = (len >= ID3V2_HEADER_LEN) ? s_id3v2_len(frame_ptr) :
+                                                       0;
+        uint32_t consumed = (tag_len < len) ? tag_len : len;
+        s_decoder_consume(dec, consumed);
+        dec->skip_len = tag_len - consumed;
+
+        if (dec->skip_len > 0u)
+        {
+            return MP3LITE_NEED_MORE_DATA;
+        }
+    }
+
+    /* Dropping everything before the frame header, window by window */
+    do
+    {
+        len = s_decoder_unpulled(dec, &frame_ptr);
+        found = s_find_frame(frame_ptr, len, &offset, &header_info);
+        s_decoder_consume(dec, offset);
+        dropped += offset;
+    } while (!found && (offset > 0u) && (dropped < SYNC_SCAN_MAX));
+
+    /* The caller gets control back in long runs of damaged bytes */
+    if (!found && (offset > 0u))
+    {
+        return MP3LITE_ERR_SYNC;
+    }
+
+    len = s_decoder_unpulled(dec, &frame_ptr);
+    uint32_t frame_len = (found) ? s_frame_len(&header_info) : 0;
+
+    if (!found || (len < frame_len))
+    {
+        return MP3LITE_NEED_MORE_DATA;
+    }
+
+    /* The Xing/Info frame of fed input holds no audio, only the tags */
+    if (dec->xing_check_b)
+    {
+        mp3lite_gapless_t gapless;
+        dec->xing_check_b = false;
+
+        if (s_decode_xing(frame_ptr, &header_info, &gapless))
+        {
+            s_decoder_gapless_start(dec, &gapless);
+            s_decoder_consume(dec, frame_len);
+
+            return s_decoder_pull_frame(dec, pcm, pcm_size, frame);
+        }
+    }
+
+    /* Output settings for this frame */
+    output_cfg_t output_cfg = dec->output_cfg;
+    output_cfg.nch = s_synthesis_nch(&header_info, dec->mono_output);
+    output_cfg.plane_len = s_samples_per_frame(&header_info);
+
+    size_t pcm_size_min = ((size_t) output_cfg.plane_len * output_cfg.nch *
+                           s_output_sample_size(&output_cfg));
+    if (pcm && (pcm_size < pcm_size_min))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    int result = MP3LITE_OK;
+    const uint32_t crc_len = (header_info.protection) ? CRC_LEN : 0;
+    const uint8_t *side_info_ptr = &frame_ptr[HEADER_LEN + crc_len];
+    const uint32_t side_info_len = s_side_info_len(&header_info);
+    const uint8_t *slot = &side_info_ptr[side_info_len];
+    const uint32_t slot_len = s_frame_compressed_len(&header_info);
+    uint32_t nsamples = 0;
+    bool side_info_b = false;
+    bool main_data_b = false;
+
+    /* Checked before anything is read from the side information */
+    bool crc_error = (header_info.protection &&
+                      (dec->crc_policy != MP3LITE_CRC_SKIP) &&
+                      !s_frame_crc_ok(frame_ptr, &header_info));
+
+    if (crc_error && (dec->crc_policy == MP3LITE_CRC_DROP))
+    {
+        result = MP3LITE_ERR_CRC;
+    }
+    else if (s_decode_side_info(side_info_ptr, &dec->side_info,
+                                &header_info))
+    {
+        result = MP3LITE_ERR_SIDE_INFO;
+    }
+    else
+    {
+        side_info_b = true;
+    }
+
+    /*
+     * The slot of a dropped frame is appended all the same, the main data of
+     * the next frames may begin in it
+     */
+    const uint16_t main_data_begin = (side_info_b) ?
+                                     dec->side_info.main_data_begin : 0;
+
+    /* In place, the main data is read where it is in the caller's buffer */
+    main_data_b = (dec->map_ptr) ?
+                  s_slot_history_append(&dec->history, slot, slot_len,
+                                        main_data_begin, &dec->main_data) :
+                  s_reservoir_append(&dec->reservoir, slot, slot_len,
+                                     main_data_begin, &dec->main_data);
+    main_data_b = main_data_b && side_info_b;
+
+    if (side_info_b)
+    {
+        result = (main_data_b) ? MP3LITE_OK : MP3LITE_ERR_RESERVOIR;
+
+        /* The granules cannot be longer than the main data */
+        if (main_data_b &&
+            (s_main_data_bits(&dec->side_info, &header_info,
+                              s_num_granules(&header_info)) >
+             (dec->main_data.len * 8u)))
+        {
+            main_data_b = false;
+            result = MP3LITE_ERR_MAIN_DATA;
+        }
+    }
+
+    if (main_data_b)
+    {
+        for (uint8_t gr = 0; gr < s_num_granules(&header_info); ++gr)
+        {
+            /// TODO: Huffman decoding, requantization and stereo processing
+            /// into dec->xr, then s_downmix_mono() for mono output
+
+            /// TODO: IMDCT and synthesis into pcm with s_convert_output(),
+            /// unless dec->preroll_frames, leaving out dec->skip_samples and
+            /// what is past dec->samples_left, both counted down then
+        }
+        dec->output_cfg.nch = output_cfg.nch;
+        dec->output_cfg.plane_len = output_cfg.plane_len;
+        dec->nconcealed = 0;
+    }
+    else if (dec->conceal_b)
+    {
+        for (uint8_t gr = 0; gr < s_num_granules(&header_info); ++gr)
+        {
+            ++dec->nconcealed;
+            s_conceal_spectrum(dec->xr, NCH_MAX * GRANULE_LEN,
+                               dec->nconcealed);
+
+            /// TODO: IMDCT and synthesis of dec->xr into pcm as above
+        }
+        dec->output_cfg.nch = output_cfg.nch;
+        dec->output_cfg.plane_len = output_cfg.plane_len;
+        result = MP3LITE_CONCEALED;
+    }
+
+    dec->header_info = header_info;
+    dec->info_valid = true;
+
+    if (frame)
+    {
+        s_stream_info(&header_info, &frame->info);
+        frame->offset = dec->input_pos;
+        frame->nsamples = nsamples;
+        frame->crc_error = (crc_error) ? 1u : 0;
+    }
+
+    s_decoder_consume(dec, frame_len);
+
+    return result;
+}
+
+
+static void s_decoder_gapless_start(mp3lite_decoder_t *dec,
+                                    const mp3lite_gapless_t *gapless)
+{
+    assert(dec && gapless);
+
+    dec->gapless = *gapless;
+    dec->skip_samples += gapless->skip;
+    dec->samples_left = (gapless->nsamples > 0u) ? gapless->nsamples :
+                                                   UINT64_MAX;
+}
+
+
+int mp3lite_decoder_stream_info(const mp3lite_decoder_t *dec,
+                                mp3lite_stream_info_t *info)
+{
+    if (!dec || !info)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    if (!dec->info_valid)
+    {
+        return MP3LITE_NEED_MORE_DATA;
+    }
+
+    s_stream_info(&dec->header_info, info);
+
+    return MP3LITE_OK;
+}
+
+
+void mp3lite_decoder_flush(mp3lite_decoder_t *dec)
+{
+    if (dec)
+    {
+        if (!dec->map_ptr)
+        {
+            s_decoder_consume(dec, dec->input_end - dec->input_start);
+        }
+        dec->reservoir.len = 0;
+        dec->history.head = 0;
+        dec->history.count = 0;
+        dec->main_data.nseg = 0;
+        dec->main_data.len = 0;
+        dec->preroll_frames = 0;
+        dec->skip_samples = 0;
+        dec->samples_left = UINT64_MAX;
+        dec->skip_len = 0;
+
+        /* The last spectrum is not related to what comes next */
+        memset(dec->xr, 0, sizeof(dec->xr));
+        dec->nconcealed = 0;
+    }
+}
+
+
+void mp3lite_decoder_reset(mp3lite_decoder_t *dec)
+{
+    if (dec)
+    {
+        output_cfg_t output_cfg = dec->output_cfg;
+        bool mono_output = dec->mono_output;
+        uint8_t crc_policy = dec->crc_policy;
+        bool conceal_b = dec->conceal_b;
+
+        memset(dec, 0, sizeof(mp3lite_decoder_t));
+
+        dec->output_cfg = output_cfg;
+        dec->mono_output = mono_output;
+        dec->crc_policy = crc_policy;
+        dec->conceal_b = conceal_b;
+        dec->samples_left = UINT64_MAX;
+        dec->xing_check_b = true;
+    }
+}
+
+
+int mp3lite_decoder_gapless(const mp3lite_decoder_t *dec,
+                            mp3lite_gapless_t *gapless)
+{
+    if (!dec || !gapless)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    if (dec->xing_check_b)
+    {
+        return MP3LITE_NEED_MORE_DATA;
+    }
+
+    *gapless = dec->gapless;
+
+    return MP3LITE_OK;
+}
+
+#endif
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for splitting a stream into chunks      *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Frames decoded before a chunk on top of the frames that hold its main data,
+ * the IMDCT overlap and the synthesis V vector reach back less than a frame
+ */
+#define PREROLL_WARMUP_FRAMES 1u
+
+/*
+ * Frames kept while scanning, the warm-up frames and the frames their main
+ * data can reach back to
+ */
+#define SPLIT_HISTORY_LEN (PREROLL_WARMUP_FRAMES + MAIN_DATA_SEG_MAX)
+
+/*
+ * Ring of the last frames scanned
+ *
+ * Members
+ * -------
+ * offset           Byte offset of the frame header
+ *
+ * slot_len         Main data slot length of the frame in bytes
+ *
+ * main_data_begin  From the side information of the frame
+ *
+ * head             Index of the next frame written
+ *
+ * count            Number of frames in the ring
+ */
+typedef struct {
+    size_t offset[SPLIT_HISTORY_LEN];
+    uint32_t slot_len[SPLIT_HISTORY_LEN];
+    uint16_t main_data_begin[SPLIT_HISTORY_LEN];
+    uint32_t head;
+    uint32_t count;
+} split_history_t;
+
+/*
+ * Searching for the next complete frame the same way mp3lite_decoder_pull()
+ * does when decoding in place
+ *
+ * \param pos   Where the search starts, the offset of the frame if found
+ *
+ * \return      true if a complete frame is found
+ */
+static bool s_next_frame(const uint8_t *data,
+                         const size_t size,
+                         size_t *pos,
+                         header_info_t *header_info);
+
+/*
+ * \param frame_ptr     Pointer to the frame header
+ *
+ * \return              main_data_begin of the frame
+ */
+static uint16_t s_read_main_data_begin(const uint8_t *frame_ptr,
+                                       const header_info_t *header_info);
+
+/*
+ * Adding the frame at data[pos] to the history, the oldest frame is dropped
+ * if the history is full
+ */
+static void s_split_history_append(split_history_t *history,
+                                   const uint8_t *data,
+                                   const size_t pos,
+                                   const header_info_t *header_info);
+
+/*
+ * \return  Byte offset of the frame n frames before the last frame of the
+ *          history, n < history->count
+ */
+static size_t s_split_history_offset(const split_history_t *history,
+                                     const uint32_t n);
+
+/*
+ * Counting the frames to decode before the last frame of the history, so
+ * that it and the PREROLL_WARMUP_FRAMES frames before it find their main data
+ *
+ * \return  Number of pre-roll frames, smaller near the start of the stream
+ */
+static uint32_t s_split_preroll(const split_history_t *history);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for splitting a stream into chunks                            *
+ *                                                                           *
+ *****************************************************************************/
+
+static bool s_next_frame(const uint8_t *data,
+                         const size_t size,
+                         size_t *pos,
+                         header_info_t *header_info)
+{
+    assert(data && pos && header_info && (*pos <= size));
+
+    uint32_t offset = 0;
+    bool found = false;
+
+    /* Window by window, as in s_decoder_unpulled() */
+    do
+    {
+        size_t remaining = size - *pos;
+        uint32_t len = (remaining < SCAN_WINDOW_LEN) ? (uint32_t) remaining :
+                                                       SCAN_WINDOW_LEN;
+        found = s_find_frame(&data[*pos], len, &offset, header_info);
+        *pos += offset;
+    } while (!found && (offset > 0u));
+
+    return (found && ((size - *pos) >= s_frame_len(header_info)));
+}
+
+
+static uint16_t s_read_main_data_begin(const uint8_t *frame_ptr,
+                                       const header_info_t *header_info)
+{
+    assert(frame_ptr && header_info);
+
+    const uint32_t crc_len = (header_info->protection) ? CRC_LEN : 0;
+
+    /* The first 9 bits (MPEG-1) or 8 bits (MPEG-2/2.5) of the side info */
+    if (header_info->ver != 1u)
+    {
+        return frame_ptr[HEADER_LEN + crc_len];
+    }
+
+    return (uint16_t) (s_copy_bitstream_u16(&frame_ptr[HEADER_LEN + crc_len])
+                       >> 7);
+}
+
+
+static void s_split_history_append(split_history_t *history,
+                                   const uint8_t *data,
+                                   const size_t pos,
+                                   const header_info_t *header_info)
+{
+    assert(history && data && header_info);
+
+    history->offset[history->head] = pos;
+    history->slot_len[history->head] = s_frame_compressed_len(header_info);
+    history->main_data_begin[history->head] =
+        s_read_main_data_begin(&data[pos], header_info);
+    history->head = (history->head + 1u) % SPLIT_HISTORY_LEN;
+    history->count += (history->count < SPLIT_HISTORY_LEN) ? 1u : 0u;
+}
+
+
+static size_t s_split_history_offset(const split_history_t *history,
+                                     const uint32_t n)
+{
+    assert(history && (n < history->count));
+
+    return history->offset[(history->head + SPLIT_HISTORY_LEN - 1u - n) %
+                           SPLIT_HISTORY_LEN];
+}
+
+
+static uint32_t s_split_preroll(const split_history_t *history)
+{
+    assert(history && (history->count > 0u));
+
+    /* Logical index 0 is the oldest frame, first is the frame of the chunk */
+    const uint32_t oldest = (history->head + SPLIT_HISTORY_LEN -
+                             history->count) % SPLIT_HISTORY_LEN;
+    const uint32_t first = history->count - 1u;
+    const uint32_t warm = (first > PREROLL_WARMUP_FRAMES) ?
+                          (first - PREROLL_WARMUP_FRAMES) : 0;
+    uint32_t start = first;
+
+    for (uint32_t f = warm; f <= first; ++f)
+    {
+        uint32_t idx = (oldest + f) % SPLIT_HISTORY_LEN;
+        uint32_t main_data_begin = history->main_data_begin[idx];
+        uint32_t prev_len = 0;
+        uint32_t g = f;
+
+        /* Walking back until main_data_begin is covered */
+        while ((prev_len < main_data_begin) && (g > 0u))
+        {
+            --g;
+            prev_len += history->slot_len[(oldest + g) % SPLIT_HISTORY_LEN];
+        }
+
+        start = (g < start) ? g : start;
+    }
+
+    return first - start;
+}
+
+
+uint32_t mp3lite_split(const uint8_t *data,
+                       const size_t size,
+                       mp3lite_chunk_t *chunks,
+                       const uint32_t max_chunks)
+{
+    if (!data || !chunks || (max_chunks == 0u))
+    {
+        return 0;
+    }
+
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+    uint32_t total = 0;
+
+    s_stream_bounds(data, size, &start, &end);
+
+    /* The Xing/Info frame is not decoded, it is in no chunk */
+    start = s_find_xing(data, start, end, &xing_pos, &gapless);
+    size_t pos = start;
+
+    /* First pass, counting the frames */
+    while (s_next_frame(data, end, &pos, &header_info))
+    {
+        pos += s_frame_len(&header_info);
+        ++total;
+    }
+
+    const uint32_t nchunks = (total < max_chunks) ? total : max_chunks;
+
+    /* Second pass, chunk k starts at frame k * total / nchunks */
+    split_history_t history;
+    memset(&history, 0, sizeof(history));
+    pos = start;
+
+    for (uint32_t i = 0, k = 0; k < nchunks; ++i)
+    {
+        bool found_b = s_next_frame(data, end, &pos, &header_info);
+        assert(found_b);
+        (void) found_b;
+
+        s_split_history_append(&history, data, pos, &header_info);
+
+        uint32_t first = (uint32_t) (((uint64_t) k * total) / nchunks);
+        if (i == first)
+        {
+            uint32_t next = (uint32_t) (((uint64_t) (k + 1u) * total) /
+                                        nchunks);
+            uint32_t preroll = s_split_preroll(&history);
+
+            chunks[k].preroll_offset = s_split_history_offset(&history,
+                                                              preroll);
+            chunks[k].offset = pos;
+            chunks[k].preroll_frames = preroll;
+            chunks[k].nframes = next - first;
+
+            if (k > 0u)
+            {
+                chunks[k - 1u].end = pos;
+            }
+            ++k;
+        }
+
+        pos += s_frame_len(&header_info);
+    }
+
+    if (nchunks > 0u)
+    {
+        chunks[nchunks - 1u].end = end;
+    }
+
+    return nchunks;
+}
+
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for seeking                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+int mp3lite_decoder_seek(mp3lite_decoder_t *dec, const uint64_t sample)
+{
+    if (!dec || !dec->map_ptr)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *data = dec->map_ptr;
+    const size_t size = dec->map_size;
+    header_info_t header_info;
+    split_history_t history;
+    memset(&history, 0, sizeof(history));
+    size_t pos = dec->map_start;
+    uint64_t frame_start = 0;
+    bool found = false;
+
+    /* The sample is counted from the end of the delay */
+    const uint64_t target = sample + dec->gapless.skip;
+    const uint64_t nsamples = dec->gapless.nsamples;
+
+    if ((nsamples > 0u) && (sample >= nsamples))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    /* Header-only walk to the frame holding the target sample */
+    while (!found && s_next_frame(data, size, &pos, &header_info))
+    {
+        uint32_t samples_per_frame = s_samples_per_frame(&header_info);
+
+        s_split_history_append(&history, data, pos, &header_info);
+        found = (target < (frame_start + samples_per_frame));
+
+        if (!found)
+        {
+            frame_start += samples_per_frame;
+            pos += s_frame_len(&header_info);
+        }
+    }
+
+    if (!found)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    /* The pre-roll is the same as for the first frame of a chunk */
+    const uint32_t preroll = s_split_preroll(&history);
+
+    s_decoder_map(dec, data, s_split_history_offset(&history, preroll), size);
+    dec->preroll_frames = preroll;
+    dec->skip_samples = (uint32_t) (target - frame_start);
+    dec->samples_left = (nsamples > 0u) ? (nsamples - sample) : UINT64_MAX;
+
+    return MP3LITE_OK;
+}
+
+#endif
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for cutting a stream                    *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Turning a copy of a frame into a silent frame that only carries its main
+ * data slot into the bit reservoir
+ *
+ * The side information is zeroed (main_data_begin and part2_3_length are 0,
+ * the granules decode to silence) and the CRC is rewritten, the slot is
+ * left as it is
+ *
+ * \param frame_ptr     Pointer to the copied frame header, the header, CRC
+ *                      and side information MUST be writable
+ */
+static void s_cut_carrier(uint8_t *frame_ptr,
+                          const header_info_t *header_info);
+
+/*
+ * Copying the frame at data[pos] to dest
+ *
+ * \param carrier_b     true to make it a carrier, see s_cut_carrier()
+ *
+ * \return              Frame length in bytes
+ */
+static uint32_t s_cut_copy(uint8_t *dest,
+                           const uint8_t *data,
+                           const size_t pos,
+                           const bool carrier_b);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for cutting a stream                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+static void s_cut_carrier(uint8_t *frame_ptr,
+                          const header_info_t *header_info)
+{
+    assert(frame_ptr && header_info);
+
+    const uint32_t crc_len = (header_info->protection) ? CRC_LEN : 0;
+    memset(&frame_ptr[HEADER_LEN + crc_len], 0,
+           s_side_info_len(header_info));
+
+    if (header_info->protection)
+    {
+        s_frame_crc_write(frame_ptr, header_info);
+    }
+}
+
+
+static uint32_t s_cut_copy(uint8_t *dest,
+                           const uint8_t *data,
+                           const size_t pos,
+                           const bool carrier_b)
+{
+    assert(dest && data);
+
+    header_info_t header_info;
+    (void) s_frame_header_valid(&data[pos], &header_info);
+    const uint32_t frame_len = s_frame_len(&header_info);
+
+    memcpy(dest, &data[pos], frame_len);
+    if (carrier_b)
+    {
+        s_cut_carrier(dest, &header_info);
+    }
+
+    return frame_len;
+}
+
+
+int mp3lite_cut(const uint8_t *data,
+                const size_t size,
+                const uint64_t sample,
+                const uint64_t nsamples,
+                uint8_t *dest,
+                const size_t dest_size,
+                mp3lite_cut_t *cut)
+{
+    if (!data || !cut || (nsamples == 0u))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    memset(cut, 0, sizeof(mp3lite_cut_t));
+
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+    split_history_t history;
+    memset(&history, 0, sizeof(history));
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+
+    /* Samples are counted as in mp3lite_decoder_seek() */
+    s_stream_bounds(data, size, &start, &end);
+    size_t pos = s_find_xing(data, start, end, &xing_pos, &gapless);
+    const uint64_t first = sample + gapless.skip;
+    const uint64_t last = first + nsamples;
+    uint64_t frame_start = 0;
+
+    /* Bytes of main data the kept frames need before the first kept slot */
+    uint32_t reach = 0;
+    uint32_t slot_sum = 0;
+
+    while ((frame_start < last) && s_next_frame(data, end, &pos, &header_info))
+    {
+        const uint32_t samples_per_frame = s_samples_per_frame(&header_info);
+        const uint32_t frame_len = s_frame_len(&header_info);
+
+        if (cut->nframes == 0u)
+        {
+            s_split_history_append(&history, data, pos, &header_info);
+        }
+
+        if ((cut->nframes > 0u) || (first < (frame_start + samples_per_frame)))
+        {
+            uint32_t main_data_begin = s_read_main_data_begin(&data[pos],
+                                                              &header_info);
+
+            if (cut->nframes == 0u)
+            {
+                cut->offset = pos;
+                cut->skip = (uint32_t) (first - frame_start);
+            }
+
+            /* Only the frames within MAIN_DATA_BEGIN_MAX bytes can reach */
+            if (slot_sum < MAIN_DATA_BEGIN_MAX)
+            {
+                reach = ((main_data_begin > slot_sum) &&
+                         ((main_data_begin - slot_sum) > reach)) ?
+                        (main_data_begin - slot_sum) : reach;
+                slot_sum += s_frame_compressed_len(&header_info);
+            }
+
+            ++cut->nframes;
+            cut->nsamples += samples_per_frame;
+            cut->len += frame_len;
+            cut->end = pos + frame_len;
+        }
+
+        frame_start += samples_per_frame;
+        pos += frame_len;
+    }
+
+    if (cut->nframes == 0u)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    /* The stream may end before the range */
+    const uint64_t kept = cut->nsamples - cut->skip;
+    cut->padding = (kept > nsamples) ? (uint32_t) (kept - nsamples) : 0;
+
+    /* The frames before the first kept frame whose slots hold the reach */
+    uint32_t prev_len = 0;
+    while ((prev_len < reach) && ((cut->ncarried + 1u) < history.count))
+    {
+        ++cut->ncarried;
+        uint32_t idx = (history.head + SPLIT_HISTORY_LEN - 1u -
+                        cut->ncarried) % SPLIT_HISTORY_LEN;
+        size_t carrier_pos = history.offset[idx];
+        prev_len += history.slot_len[idx];
+
+        (void) s_frame_header_valid(&data[carrier_pos], &header_info);
+        cut->len += s_frame_len(&header_info);
+        cut->nsamples += s_samples_per_frame(&header_info);
+        cut->skip += s_samples_per_frame(&header_info);
+    }
+
+    if (!dest)
+    {
+        return MP3LITE_OK;
+    }
+
+    if (dest_size < cut->len)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    /* The carriers, oldest first, then the kept frames as they are */
+    size_t len = 0;
+    for (uint32_t n = cut->ncarried; n > 0u; --n)
+    {
+        len += s_cut_copy(&dest[len], data,
+                          s_split_history_offset(&history, n), true);
+    }
+
+    pos = cut->offset;
+    for (uint32_t i = 0; i < cut->nframes; ++i)
+    {
+        (void) s_next_frame(data, end, &pos, &header_info);
+        uint32_t frame_len = s_cut_copy(&dest[len], data, pos, false);
+        pos += frame_len;
+        len += frame_len;
+    }
+
+    return MP3LITE_OK;
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for gain adjustment                     *
+ *                                                                           *
+ *****************************************************************************/
+
+/* global_gain follows part2_3_length (12 bits) and big_values (9 bits) */
+#define GLOBAL_GAIN_BIT_OFFSET 21u
+
+/* 8 bits, one step is 1.5 dB (2^(1/4) in amplitude) */
+#define GLOBAL_GAIN_MAX 255
+
+/*
+ * \return  Bit offset of global_gain of [gr][ch] from the start of the side
+ *          information, see s_decode_side_info_gr_ch()
+ */
+static uint32_t s_global_gain_pos(const uint8_t gr,
+                                  const uint8_t ch,
+                                  const header_info_t *header_info);
+
+/*
+ * Adding step to every global_gain of a frame in place, the rest of the
+ * side information and the main data are left as they are
+ *
+ * The CRC is rewritten if it matched before, a damaged frame keeps its
+ * mismatching CRC
+ *
+ * \param frame_ptr     Pointer to the frame header, the header, CRC and side
+ *                      information MUST be writable
+ *
+ * \return              Number of global_gain clamped to 0 or
+ *                      GLOBAL_GAIN_MAX
+ */
+static uint32_t s_frame_add_gain(uint8_t *frame_ptr,
+                                 const header_info_t *header_info,
+                                 const int32_t step);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for gain adjustment                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint32_t s_global_gain_pos(const uint8_t gr,
+                                  const uint8_t ch,
+                                  const header_info_t *header_info)
+{
+    assert(header_info);
+
+    /* Same layout as in s_decode_side_info_gr_ch() */
+    const bool lsf_b = (header_info->ver != 1u);
+    const uint32_t nch = (header_info->mode == 3u) ? 1u : 2u;
+    const uint32_t pre_gr_ch_bits = (lsf_b) ? ((nch == 1u) ? 9u : 10u) :
+                                              ((nch == 1u) ? 18u : 20u);
+    const uint32_t gr_ch_bitsize = (lsf_b) ? 63u : 59u;
+
+    return pre_gr_ch_bits + ((((uint32_t) gr * nch) + ch) * gr_ch_bitsize) +
+           GLOBAL_GAIN_BIT_OFFSET;
+}
+
+
+static uint32_t s_frame_add_gain(uint8_t *frame_ptr,
+                                 const header_info_t *header_info,
+                                 const int32_t step)
+{
+    assert(frame_ptr && header_info);
+
+    const bool crc_ok_b = (header_info->protection &&
+                           s_frame_crc_ok(frame_ptr, header_info));
+    const uint32_t crc_len = (header_info->protection) ? CRC_LEN : 0;
+    uint8_t *side_info_ptr = &frame_ptr[HEADER_LEN + crc_len];
+    const uint8_t nch = (header_info->mode == 3u) ? 1u : 2u;
+    uint32_t nclipped = 0;
+
+    for (uint8_t gr = 0; gr < s_num_granules(header_info); ++gr)
+    {
+        for (uint8_t ch = 0; ch < nch; ++ch)
+        {
+            /* 8 bits across at most two bytes, big endian */
+            const uint32_t pos = s_global_gain_pos(gr, ch, header_info);
+            const uint32_t idx = pos / 8u;
+            const uint32_t bitshift = 8u - (pos % 8u);
+            uint32_t bits = ((uint32_t) side_info_ptr[idx] << 8) |
+                            (uint32_t) side_info_ptr[idx + 1u];
+
+            int32_t gain = (int32_t) ((bits >> bitshift) & 0xFFu) + step;
+            nclipped += ((gain < 0) || (gain > GLOBAL_GAIN_MAX)) ? 1u : 0u;
+            gain = (gain < 0) ? 0 :
+                   (gain > GLOBAL_GAIN_MAX) ? GLOBAL_GAIN_MAX : gain;
+
+            bits = (bits & ~(0xFFu << bitshift)) |
+                   ((uint32_t) gain << bitshift);
+            side_info_ptr[idx] = (uint8_t) (bits >> 8);
+            side_info_ptr[idx + 1u] = (uint8_t) bits;
+        }
+    }
+
+    if (crc_ok_b)
+    {
+        s_frame_crc_write(frame_ptr, header_info);
+    }
+
+    return nclipped;
+}
+
+
+int mp3lite_apply_gain(uint8_t *data,
+                       const size_t size,
+                       const int32_t step,
+                       mp3lite_gain_t *gain)
+{
+    if (!data || !gain || (step < -GLOBAL_GAIN_MAX) ||
+        (step > GLOBAL_GAIN_MAX))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    memset(gain, 0, sizeof(mp3lite_gain_t));
+
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+
+    /* The Xing/Info frame has no audio to scale */
+    s_stream_bounds(data, size, &start, &end);
+    size_t pos = s_find_xing(data, start, end, &xing_pos, &gapless);
+
+    while (s_next_frame(data, end, &pos, &header_info))
+    {
+        gain->ncrc_error += (header_info.protection &&
+                             !s_frame_crc_ok(&data[pos], &header_info)) ?
+                            1u : 0u;
+        gain->nclipped += s_frame_add_gain(&data[pos], &header_info, step);
+        ++gain->nframes;
+
+        pos += s_frame_len(&header_info);
+    }
+
+    return MP3LITE_OK;
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for silence estimation                  *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Activity of a frame, see s_frame_activity() */
+#define FRAME_SILENT    0u
+#define FRAME_LOW       1u
+#define FRAME_ACTIVE    2u
+
+/* Level of a coefficient at global_gain 210, 20 * log10(2) / 4 dB a step */
+#define GLOBAL_GAIN_REF     210
+#define GLOBAL_GAIN_STEP_DB 1.5051499783199060
+
+/* Level of a granule without Huffman code data */
+#define SILENCE_FLOOR_DB    (-1000.0)
+
+/*
+ * Upper bound of the coefficients of a granule and channel from its side
+ * information alone
+ *
+ * Scalefactors, preflag and subblock_gain only attenuate, so a quantized
+ * value of |is| is at most is^(4/3) * 2^((global_gain - 210) / 4). |is| is
+ * bounded by the largest value of the Huffman tables of the big_values
+ * regions (1 in the count1 region). MS stereo adds up to 3 dB
+ *
+ * \param ms_b      true for a frame with MS stereo
+ *
+ * \return          Level in dB relative to a coefficient of 1.0, which is
+ *                  about the peak level in dBFS of a tone; SILENCE_FLOOR_DB
+ *                  if part2_3_length is 0 (every coefficient is 0)
+ */
+static double s_granule_peak_db(const side_info_gr_ch_t *gr_ch,
+                                const bool ms_b);
+
+/*
+ * Classifying a frame from the side information alone
+ *
+ * \return  FRAME_SILENT: every granule and channel is below
+ *                        cfg->threshold
+ *          FRAME_LOW:    above it but every part2_3_length is at most
+ *                        cfg->low_bits, the bound is not tight for so few
+ *                        bits
+ *          FRAME_ACTIVE: otherwise, or if the side information is invalid
+ */
+static uint8_t s_frame_activity(const uint8_t *frame_ptr,
+                                const header_info_t *header_info,
+                                const mp3lite_silence_cfg_t *cfg);
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for silence estimation                                        *
+ *                                                                           *
+ *****************************************************************************/
+
+static double s_granule_peak_db(const side_info_gr_ch_t *gr_ch,
+                                const bool ms_b)
+{
+    assert(gr_ch);
+
+    /* Largest |is| of each Huffman table (ISO/IEC 11172-3 Table B.7), */
+    /* 15 + 2^linbits - 1 from table 16, 4 and 14 are not used (15)    */
+    static const uint16_t s_table_max[32] = {
+        0, 1, 2, 2, 15, 3, 3, 5, 5, 5, 7, 7, 7, 15, 15, 15,
+        16, 18, 22, 30, 78, 270, 1038, 8206,
+        30, 46, 78, 142, 270, 526, 2062, 8206
+    };
+
+    if (gr_ch->part2_3_length == 0u)
+    {
+        return SILENCE_FLOOR_DB;
+    }
+
+    /* The count1 region, then the regions of big_values */
+    uint32_t is_max = 1;
+    const uint8_t nregions = (gr_ch->window_switching_flag) ? 2u : 3u;
+    for (uint8_t i = 0; (gr_ch->big_values > 0u) && (i < nregions); ++i)
+    {
+        uint32_t table_max = s_table_max[gr_ch->table_select[i] & 0x1Fu];
+        is_max = (table_max > is_max) ? table_max : is_max;
+    }
+
+    /* 20 * log10(is_max^(4/3)) */
+    double level = (GLOBAL_GAIN_STEP_DB *
+                    (double) ((int32_t) gr_ch->global_gain -
+                              GLOBAL_GAIN_REF)) +
+                   ((8.0 / 3.0) * s_db10((double) is_max));
+
+    /* 20 * log10(sqrt(2)) */
+    return (ms_b) ? (level + 3.0102999566398120) : level;
+}
+
+
+static uint8_t s_frame_activity(const uint8_t *frame_ptr,
+                                const header_info_t *header_info,
+                                const mp3lite_silence_cfg_t *cfg)
+{
+    assert(frame_ptr && header_info && cfg);
+
+    side_info_t side_info;
+    const uint32_t crc_len = (header_info->protection) ? CRC_LEN : 0;
+
+    if (s_decode_side_info(&frame_ptr[HEADER_LEN + crc_len], &side_info,
+                           header_info))
+    {
+        return FRAME_ACTIVE;
+    }
+
+    const uint8_t nch = (header_info->mode == 3u) ? 1u : 2u;
+    const bool ms_b = ((header_info->mode == 1u) &&
+                       ((header_info->mode_ext & 0x02u) != 0u));
+    uint8_t activity = FRAME_SILENT;
+
+    for (uint8_t gr = 0; gr < s_num_granules(header_info); ++gr)
+    {
+        for (uint8_t ch = 0; ch < nch; ++ch)
+        {
+            const side_info_gr_ch_t *gr_ch =
+                &side_info.gr_ch[s_gr_ch_idx(gr, ch)];
+
+            if (s_granule_peak_db(gr_ch, ms_b) > cfg->threshold)
+            {
+                activity = (gr_ch->part2_3_length > cfg->low_bits) ?
+                           FRAME_ACTIVE : FRAME_LOW;
+            }
+
+            if (activity == FRAME_ACTIVE)
+            {
+                return activity;
+            }
+        }
+    }
+
+    return activity;
+}
+
+
+int mp3lite_estimate_silence(const uint8_t *data,
+                             const size_t size,
+                             const mp3lite_silence_cfg_t *cfg,
+                             mp3lite_segment_t *segments,
+                             const uint32_t max_segments,
+                             mp3lite_silence_t *silence)
+{
+    if (!data || !cfg || !silence || (!segments && (max_segments > 0u)) ||
+        (cfg->flags > MP3LITE_SILENCE_LOW))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    memset(silence, 0, sizeof(mp3lite_silence_t));
+
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+
+    /* Samples are counted as in mp3lite_decoder_seek() */
+    s_stream_bounds(data, size, &start, &end);
+    size_t pos = s_find_xing(data, start, end, &xing_pos, &gapless);
+    const uint64_t nsamples_max = (gapless.nsamples > 0u) ? gapless.nsamples :
+                                                            UINT64_MAX;
+    uint64_t frame_start = 0;
+
+    /* First sample of the current run of silent frames */
+    bool run_b = false;
+    uint64_t run_start = 0;
+    bool leading_b = true;
+
+    while (s_next_frame(data, end, &pos, &header_info))
+    {
+        uint8_t activity = s_frame_activity(&data[pos], &header_info, cfg);
+
+        ++silence->nframes;
+        silence->nsilent += (activity == FRAME_SILENT) ? 1u : 0u;
+        silence->nlow += (activity == FRAME_LOW) ? 1u : 0u;
+        activity = ((activity == FRAME_LOW) &&
+                    (cfg->flags & MP3LITE_SILENCE_LOW)) ?
+                   FRAME_SILENT : activity;
+
+        /* Sample range of the frame, clipped to the playable samples */
+        uint64_t first = frame_start;
+        frame_start += s_samples_per_frame(&header_info);
+        first = (first > gapless.skip) ? (first - gapless.skip) : 0u;
+        first = (first < nsamples_max) ? first : nsamples_max;
+
+        if ((activity == FRAME_SILENT) && !run_b)
+        {
+            run_b = true;
+            run_start = first;
+        }
+        else if ((activity != FRAME_SILENT) && run_b)
+        {
+            run_b = false;
+
+            if (leading_b)
+            {
+                silence->trim_start = first;
+            }
+
+            if ((first > run_start) && ((first - run_start) >= cfg->min_len))
+            {
+                if (silence->nsegments < max_segments)
+                {
+                    segments[silence->nsegments].start = run_start;
+                    segments[silence->nsegments].len = first - run_start;
+                }
+                ++silence->nsegments;
+            }
+        }
+
+        leading_b = leading_b && (activity == FRAME_SILENT);
+        pos += s_frame_len(&header_info);
+    }
+
+    silence->nsamples = (frame_start > gapless.skip) ?
+                        (frame_start - gapless.skip) : 0u;
+    silence->nsamples = (silence->nsamples < nsamples_max) ?
+                        silence->nsamples : nsamples_max;
+    silence->trim_end = silence->nsamples;
+
+    if (leading_b)
+    {
+        /* Nothing but silence */
+        silence->trim_start = 0;
+        silence->trim_end = 0;
+    }
+    else if (run_b)
+    {
+        silence->trim_end = run_start;
+    }
+
+    if (run_b && (silence->nsamples > run_start) &&
+        ((silence->nsamples - run_start) >= cfg->min_len))
+    {
+        if (silence->nsegments < max_segments)
+        {
+            segments[silence->nsegments].start = run_start;
+            segments[silence->nsegments].len = silence->nsamples - run_start;
+        }
+        ++silence->nsegments;
+    }
+
+    return MP3LITE_OK;
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for scanning a stream                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+int mp3lite_scan(const uint8_t *data,
+                 const size_t size,
+                 const uint32_t flags,
+                 mp3lite_scan_t *scan)
+{
+    if (!data || !scan || (flags > MP3LITE_SCAN_SIDE_INFO))
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+    memset(scan, 0, sizeof(mp3lite_scan_t));
+
+    header_info_t header_info;
+    side_info_t side_info;
+    mp3lite_gapless_t gapless;
+    size_t start = 0;
+    size_t end = 0;
+    size_t xing_pos = 0;
+    uint64_t frames_len = 0;
+    uint64_t frames_nsamples = 0;
+
+    s_stream_bounds(data, size, &start, &end);
+
+    /* The Xing/Info frame holds no audio, it is counted with the tags */
+    size_t pos = s_find_xing(data, start, end, &xing_pos, &gapless);
+    const size_t audio_start = pos;
+
+    while (s_next_frame(data, end, &pos, &header_info))
+    {
+        const uint32_t frame_len = s_frame_len(&header_info);
+        const uint8_t nch = (header_info.mode == 3u) ? 1u : 2u;
+
+        if (scan->nframes == 0u)
+        {
+            scan->freq = header_info.freq;
+            scan->bitrate_min = header_info.bitrate;
+            scan->bitrate_max = header_info.bitrate;
+        }
+
+        ++scan->nframes;
+        frames_nsamples += s_samples_per_frame(&header_info);
+        frames_len += frame_len;
+
+        scan->bitrate_min = (header_info.bitrate < scan->bitrate_min) ?
+                            header_info.bitrate : scan->bitrate_min;
+        scan->bitrate_max = (header_info.bitrate > scan->bitrate_max) ?
+                            header_info.bitrate : scan->bitrate_max;
+        ++scan->bitrate_hist[data[pos + 2u] >> 4];
+        ++scan->mode[header_info.mode];
+        scan->mode_ext[header_info.mode_ext] += (header_info.mode == 1u) ?
+                                                1u : 0u;
+
+        if (flags & MP3LITE_SCAN_SIDE_INFO)
+        {
+            const uint32_t crc_len = (header_info.protection) ? CRC_LEN : 0;
+
+            if (s_decode_side_info(&data[pos + HEADER_LEN + crc_len],
+                                   &side_info, &header_info))
+            {
+                ++scan->side_info_err;
+            }
+            else
+            {
+                for (uint8_t gr = 0; gr < s_num_granules(&header_info); ++gr)
+                {
+                    for (uint8_t ch = 0; ch < nch; ++ch)
+                    {
+                        const side_info_gr_ch_t *gr_ch =
+                            &side_info.gr_ch[s_gr_ch_idx(gr, ch)];
+
+                        /* block_type is 0 without window switching */
+                        ++scan->block_type[gr_ch->block_type];
+                        scan->mixed_block += (gr_ch->window_switching_flag &&
+                                              (gr_ch->mixed_block_flag == 1u)) ?
+                                             1u : 0u;
+                    }
+                }
+            }
+        }
+
+        pos += frame_len;
+    }
+
+    scan->vbr = (scan->bitrate_min != scan->bitrate_max) ? 1u : 0u;
+    scan->tag_len = size - (end - audio_start);
+    scan->junk_len = (end - audio_start) - frames_len;
+
+    /* Without the delay and the padding, as decoded */
+    scan->nsamples = ((gapless.nsamples > 0u) &&
+                      (gapless.nsamples < frames_nsamples)) ?
+                     gapless.nsamples : frames_nsamples;
+
+    /* kbits/s = bytes * 8 * freq / (nsamples * 1000), rounded */
+    if (frames_nsamples > 0u)
+    {
+        uint64_t den = frames_nsamples * 1000u;
+        scan->bitrate_avg = (uint16_t) (((frames_len * 8u * scan->freq) +
+                                         (den / 2u)) / den);
+    }
+
+    return MP3LITE_OK;
+}
+
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+#if defined (MP3LITE_USE_PREAD) || defined (MP3LITE_USE_IO_URING)
+/*****************************************************************************
+ *                                                                           *
+ * Typedef's and function prototypes for the file reader                     *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Alignment of the first block in the reader memory, in bytes */
+#define READER_BLOCK_ALIGN 64u
+
+/* States of a block */
+#define BLOCK_IDLE      0u  /* To be read with pread when it is needed */
+#define BLOCK_IN_FLIGHT 1u  /* Read queued in the io_uring */
+#define BLOCK_READY     2u  /* Read done (up to the end of the file) */
+
+/*
+ * Members
+ * -------
+ * ptr      Block memory, block_len bytes
+ *
+ * offset   File offset of ptr[0]
+ *
+ * len      Number of bytes read so far, less than block_len only at the end
+ *          of the file once the block is ready
+ *
+ * fed      Number of bytes fed to the decoder
+ *
+ * state    BLOCK_IDLE, BLOCK_IN_FLIGHT or BLOCK_READY
+ */
+typedef struct {
+    uint8_t *ptr;
+    uint64_t offset;
+    uint32_t len;
+    uint32_t fed;
+    uint8_t state;
+} reader_block_t;
+
+#if defined (MP3LITE_USE_IO_URING)
+/*
+ * The rings shared with the kernel, see io_uring_setup(2)
+ */
+typedef struct {
+    int ring_fd;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    uint32_t *sq_tail;
+    uint32_t *sq_mask;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t *cq_mask;
+    struct io_uring_cqe *cqes;
+} reader_uring_t;
+#endif
+
+/*
+ * Members
+ * -------
+ * fd           File read
+ *
+ * block_len    Size of a block in bytes
+ *
+ * nblocks      Number of blocks
+ *
+ * blocks       Blocks in file order from head, wrapping around
+ *
+ * head         Index of the block being fed
+ *
+ * next_offset  File offset of the next block to be queued
+ *
+ * in_flight    Number of reads queued in the io_uring
+ *
+ * err          errno of the first failed read, 0 if none
+ *
+ * uring_b      true if reads go through the io_uring (MP3LITE_USE_IO_URING)
+ *
+ * uring        The io_uring (MP3LITE_USE_IO_URING)
+ */
+struct mp3lite_reader {
+    int fd;
+    uint32_t block_len;
+    uint32_t nblocks;
+    reader_block_t blocks[MP3LITE_READER_BLOCKS_MAX];
+    uint32_t head;
+    uint64_t next_offset;
+    uint32_t in_flight;
+    int err;
+#if defined (MP3LITE_USE_IO_URING)
+    bool uring_b;
+    reader_uring_t uring;
+#endif
+};
+
+/*
+ * Initializing a reader, see mp3lite_reader_init()
+ *
+ * \param uring_b   false to read with pread only
+ */
+static mp3lite_reader_t *s_reader_init(void *mem,
+                                       const size_t size,
+                                       const int fd,
+                                       const uint64_t offset,
+                                       const uint32_t block_len,
+                                       const uint32_t nblocks,
+                                       const bool uring_b);
+
+/*
+ * Queueing the read of the rest of a block, or leaving it to pread
+ */
+static void s_reader_submit(mp3lite_reader_t *reader, const uint32_t idx);
+
+/*
+ * Handling the result of a read of a block
+ *
+ * \param res   Number of bytes read, or -errno
+ */
+static void s_reader_complete(mp3lite_reader_t *reader,
+                              const uint32_t idx,
+                              const int64_t res);
+
+/*
+ * Waiting until the block at idx is ready
+ */
+static void s_reader_wait(mp3lite_reader_t *reader, const uint32_t idx);
+
+#if defined (MP3LITE_USE_IO_URING)
+/*
+ * \return  true if the io_uring is set up with room for entries reads
+ */
+static bool s_uring_setup(reader_uring_t *uring, const uint32_t entries);
+
+/*
+ * \return  true if the read is queued
+ */
+static bool s_uring_read(reader_uring_t *uring,
+                         const int fd,
+                         uint8_t *ptr,
+                         const uint32_t len,
+                         const uint64_t offset,
+                         const uint32_t idx);
+
+/*
+ * Handling the completed reads
+ *
+ * \param wait_b    Wait for at least one completion
+ */
+static void s_uring_reap(mp3lite_reader_t *reader, const bool wait_b);
+
+static void s_uring_close(reader_uring_t *uring);
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Source code for the file reader                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+#if defined (MP3LITE_USE_IO_URING)
+static bool s_uring_setup(reader_uring_t *uring, const uint32_t entries)
+{
+    assert(uring);
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(uring, 0, sizeof(reader_uring_t));
+
+    uring->ring_fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+    if (uring->ring_fd < 0)
+    {
+        return false;
+    }
+
+    uring->sq_size = params.sq_off.array +
+                     (params.sq_entries * sizeof(uint32_t));
+    uring->cq_size = params.cq_off.cqes +
+                     (params.cq_entries * sizeof(struct io_uring_cqe));
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    uring->sq_ptr = mmap(NULL, uring->sq_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, uring->ring_fd,
+                         IORING_OFF_SQ_RING);
+    uring->cq_ptr = mmap(NULL, uring->cq_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, uring->ring_fd,
+                         IORING_OFF_CQ_RING);
+    void *sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, uring->ring_fd,
+                      IORING_OFF_SQES);
+
+    if ((uring->sq_ptr == MAP_FAILED) || (uring->cq_ptr == MAP_FAILED) ||
+        (sqes == MAP_FAILED))
+    {
+        uring->sqes = (sqes == MAP_FAILED) ? NULL : sqes;
+        s_uring_close(uring);
+        return false;
+    }
+
+    uint8_t *sq = uring->sq_ptr;
+    uint8_t *cq = uring->cq_ptr;
+
+    uring->sqes = sqes;
+    uring->sq_tail = (uint32_t *) (void *) &sq[params.sq_off.tail];
+    uring->sq_mask = (uint32_t *) (void *) &sq[params.sq_off.ring_mask];
+    uring->sq_array = (uint32_t *) (void *) &sq[params.sq_off.array];
+    uring->cq_head = (uint32_t *) (void *) &cq[params.cq_off.head];
+    uring->cq_tail = (uint32_t *) (void *) &cq[params.cq_off.tail];
+    uring->cq_mask = (uint32_t *) (void *) &cq[params.cq_off.ring_mask];
+    uring->cqes = (struct io_uring_cqe *) (void *) &cq[params.cq_off.cqes];
+
+    return true;
+}
+
+
+static bool s_uring_read(reader_uring_t *uring,
+                         const int fd,
+                         uint8_t *ptr,
+                         const uint32_t len,
+                         const uint64_t offset,
+                         const uint32_t idx)
+{
+    assert(uring && ptr);
+
+    /* Only this thread writes the tail */
+    const uint32_t tail = *uring->sq_tail;
+    const uint32_t sq_idx = tail & *uring->sq_mask;
+    struct io_uring_sqe *sqe = &uring->sqes[sq_idx];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) ptr;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = idx;
+    uring->sq_array[sq_idx] = sq_idx;
+
+    __atomic_store_n(uring->sq_tail, tail + 1u, __ATOMIC_RELEASE);
+
+    long submitted = syscall(__NR_io_uring_enter, uring->ring_fd, 1u, 0u, 0u,
+                             NULL, 0u);
+    if (submitted != 1)
+    {
+        /* Taking the entry back, the kernel did not consume it */
+        __atomic_store_n(uring->sq_tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return (submitted == 1);
+}
+
+
+static void s_uring_reap(mp3lite_reader_t *reader, const bool wait_b)
+{
+    assert(reader);
+
+    reader_uring_t *uring = &reader->uring;
+
+    if (wait_b && (reader->in_flight > 0u))
+    {
+        (void) syscall(__NR_io_uring_enter, uring->ring_fd, 0u, 1u,
+                       IORING_ENTER_GETEVENTS, NULL, 0u);
+    }
+
+    uint32_t head = *uring->cq_head;
+    const uint32_t tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+        const uint32_t idx = (uint32_t) cqe->user_data;
+        const int32_t res = cqe->res;
+
+        ++head;
+        __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+        --reader->in_flight;
+
+        /* IORING_OP_READ needs Linux 5.6, falling back to pread */
+        if (res == -EINVAL)
+        {
+            reader->uring_b = false;
+            reader->blocks[idx].state = BLOCK_IDLE;
+        }
+        else
+        {
+            s_reader_complete(reader, idx, res);
+        }
+    }
+}
+
+
+static void s_uring_close(reader_uring_t *uring)
+{
+    assert(uring);
+
+    if (uring->sqes)
+    {
+        (void) munmap(uring->sqes, uring->sqes_size);
+    }
+    if (uring->cq_ptr && (uring->cq_ptr != MAP_FAILED))
+    {
+        (void) munmap(uring->cq_ptr, uring->cq_size);
+    }
+    if (uring->sq_ptr && (uring->sq_ptr != MAP_FAILED))
+    {
+        (void) munmap(uring->sq_ptr, uring->sq_size);
+    }
+    if (uring->ring_fd >= 0)
+    {
+        (void) close(uring->ring_fd);
+    }
+
+    memset(uring, 0, sizeof(reader_uring_t));
+    uring->ring_fd = -1;
+}
+#endif
+
+
+static void s_reader_submit(mp3lite_reader_t *reader, const uint32_t idx)
+{
+    assert(reader && (idx < reader->nblocks));
+
+    reader_block_t *block = &reader->blocks[idx];
+    block->state = BLOCK_IDLE;
+
+#if defined (MP3LITE_USE_IO_URING)
+    if (reader->uring_b &&
+        s_uring_read(&reader->uring, reader->fd, &block->ptr[block->len],
+                     reader->block_len - block->len,
+                     block->offset + block->len, idx))
+    {
+        block->state = BLOCK_IN_FLIGHT;
+        ++reader->in_flight;
+    }
+#endif
+}
+
+
+static void s_reader_complete(mp3lite_reader_t *reader,
+                              const uint32_t idx,
+                              const int64_t res)
+{
+    assert(reader && (idx < reader->nblocks));
+
+    reader_block_t *block = &reader->blocks[idx];
+
+    if ((res == -EINTR) || (res == -EAGAIN))
+    {
+        s_reader_submit(reader, idx);
+    }
+    else if (res < 0)
+    {
+        reader->err = (reader->err) ? reader->err : (int) -res;
+        block->state = BLOCK_READY;
+    }
+    else
+    {
+        /* A short read is continued, a read of 0 bytes is the end */
+        block->len += (uint32_t) res;
+        if ((res > 0) && (block->len < reader->block_len))
+        {
+            s_reader_submit(reader, idx);
+        }
+        else
+        {
+            block->state = BLOCK_READY;
+        }
+    }
+}
+
+
+static void s_reader_wait(mp3lite_reader_t *reader, const uint32_t idx)
+{
+    assert(reader && (idx < reader->nblocks));
+
+    reader_block_t *block = &reader->blocks[idx];
+
+    while ((block->state != BLOCK_READY) && !reader->err)
+    {
+#if defined (MP3LITE_USE_IO_URING)
+        if (block->state == BLOCK_IN_FLIGHT)
+        {
+            s_uring_reap(reader, true);
+            continue;
+        }
+#endif
+        ssize_t res = pread(reader->fd, &block->ptr[block->len],
+                            reader->block_len - block->len,
+                            (off_t) (block->offset + block->len));
+        s_reader_complete(reader, idx, (res < 0) ? -(int64_t) errno : res);
+    }
+}
+
+
+size_t mp3lite_reader_size(const uint32_t block_len, const uint32_t nblocks)
+{
+    size_t header = ((sizeof(mp3lite_reader_t) + READER_BLOCK_ALIGN - 1u) /
+                     READER_BLOCK_ALIGN) * READER_BLOCK_ALIGN;
+
+    return header + ((size_t) block_len * nblocks) + READER_BLOCK_ALIGN;
+}
+
+
+static mp3lite_reader_t *s_reader_init(void *mem,
+                                       const size_t size,
+                                       const int fd,
+                                       const uint64_t offset,
+                                       const uint32_t block_len,
+                                       const uint32_t nblocks,
+                                       const bool uring_b)
+{
+    if (!mem || (fd < 0) || (block_len == 0u) || (nblocks < 2u) ||
+        (nblocks > MP3LITE_READER_BLOCKS_MAX) ||
+        (size < mp3lite_reader_size(block_len, nblocks)) ||
+        (((uintptr_t) mem % MP3LITE_DECODER_ALIGN) != 0u))
+    {
+        return NULL;
+    }
+
+    mp3lite_reader_t *reader = mem;
+    memset(reader, 0, sizeof(mp3lite_reader_t));
+
+    reader->fd = fd;
+    reader->block_len = block_len;
+    reader->nblocks = nblocks;
+
+    /* The blocks follow the struct, the first one aligned */
+    uintptr_t data = (uintptr_t) &((uint8_t *) mem)[sizeof(mp3lite_reader_t)];
+    data = (data + READER_BLOCK_ALIGN - 1u) & ~(uintptr_t) (READER_BLOCK_ALIGN -
+                                                            1u);
+
+#if defined (MP3LITE_USE_IO_URING)
+    reader->uring_b = uring_b && s_uring_setup(&reader->uring, nblocks);
+    if (!reader->uring_b)
+    {
+        reader->uring.ring_fd = -1;
+    }
+#else
+    (void) uring_b;
+#endif
+
+    for (uint32_t i = 0; i < nblocks; ++i)
+    {
+        reader->blocks[i].ptr = (uint8_t *) (data + ((uintptr_t) i *
+                                                     block_len));
+        reader->blocks[i].offset = offset + ((uint64_t) i * block_len);
+        s_reader_submit(reader, i);
+    }
+    reader->next_offset = offset + ((uint64_t) nblocks * block_len);
+
+    return reader;
+}
+
+
+mp3lite_reader_t *mp3lite_reader_init(void *mem,
+                                      const size_t size,
+                                      const int fd,
+                                      const uint64_t offset,
+                                      const uint32_t block_len,
+                                      const uint32_t nblocks)
+{
+    return s_reader_init(mem, size, fd, offset, block_len, nblocks, true);
+}
+
+
+int mp3lite_reader_feed(mp3lite_reader_t *reader, mp3lite_decoder_t *dec)
+{
+    if (!reader || !dec)
+    {
+        return MP3LITE_ERR_INVALID_ARG;
+    }
+
+#if defined (MP3LITE_USE_IO_URING)
+    if (reader->uring_b)
+    {
+        s_uring_reap(reader, false);
+    }
+#endif
+
+    bool fed_b = false;
+    bool full_b = false;
+    bool end_b = false;
+
+    while (!fed_b && !full_b && !end_b && !reader->err)
+    {
+        const uint32_t idx = reader->head;
+        reader_block_t *block = &reader->blocks[idx];
+
+        /* Only waiting when nothing was fed */
+        s_reader_wait(reader, idx);
+
+        while ((block->state == BLOCK_READY) && !full_b && !end_b &&
+               !reader->err)
+        {
+            if (block->fed < block->len)
+            {
+                size_t accepted = mp3lite_decoder_feed(dec,
+                                                       &block->ptr[block->fed],
+                                                       block->len - block->fed);
+                block->fed += (uint32_t) accepted;
+                fed_b = fed_b || (accepted > 0u);
+                full_b = (block->fed < block->len);
+            }
+            else if (block->len < reader->block_len)
+            {
+                end_b = true;
+            }
+            else
+            {
+                /* Used up, reading the block again further in the file */
+                block->offset = reader->next_offset;
+                block->len = 0;
+                block->fed = 0;
+                reader->next_offset += reader->block_len;
+                s_reader_submit(reader, reader->head);
+
+                reader->head = (reader->head + 1u) % reader->nblocks;
+                block = &reader->blocks[reader->head];
+            }
+        }
+    }
+
+    if (reader->err)
+    {
+        errno = reader->err;
+        return MP3LITE_ERR_IO;
+    }
+
+    return (fed_b || full_b) ? MP3LITE_OK : MP3LITE_END_OF_STREAM;
+}
+
+
+void mp3lite_reader_close(mp3lite_reader_t *reader)
+{
+    if (reader)
+    {
+#if defined (MP3LITE_USE_IO_URING)
+        /* The kernel may still write into the blocks */
+        while (reader->in_flight > 0u)
+        {
+            s_uring_reap(reader, true);
+        }
+
+        /* Also after falling back to pread */
+        if (reader->uring.ring_fd >= 0)
+        {
+            s_uring_close(&reader->uring);
+        }
+        reader->uring_b = false;
+#endif
+        reader->in_flight = 0;
+    }
+}
+#endif /* MP3LITE_USE_PREAD || MP3LITE_USE_IO_URING */
+
+#endif
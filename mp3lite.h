@@ -5,10 +5,938 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
+/*
+ * Experimental decoder
+ * --------------------
+ * The streaming decoder, and the file reader built on it, read the frame
+ * headers, the side information and the bit reservoir only: Huffman
+ * decoding, requantization, the IMDCT and the synthesis are not implemented,
+ * so no PCM is written. They are built and declared only if
+ * MP3LITE_EXPERIMENTAL_DECODER is defined, both for mp3lite.c and before
+ * this header is included
+ *
+ * Splitting, cutting, gain adjustment, silence estimation and scanning work
+ * on the bitstream alone and are always available
+ */
+
+/*****************************************************************************
+ *                                                                           *
+ * Return codes                                                              *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Success */
+#define MP3LITE_OK                  0
+
+/* No complete frame is buffered, feed more bytes and try again */
+#define MP3LITE_NEED_MORE_DATA      1
+
+/* NULL pointer, buffer too small, or invalid setting */
+#define MP3LITE_ERR_INVALID_ARG     (-1)
+
+/*
+ * The frame refers to main data (main_data_begin) that was never fed, e.g.
+ * the first frames after a cut or a flush; the frame is skipped
+ */
+#define MP3LITE_ERR_RESERVOIR       (-2)
+
+/* The side information of the frame is invalid, the frame is skipped */
+#define MP3LITE_ERR_SIDE_INFO       (-3)
+
+/* The end of the input file was reached, see mp3lite_reader_feed() */
+#define MP3LITE_END_OF_STREAM       2
+
+/* Reading the input file failed, errno is set */
+#define MP3LITE_ERR_IO              (-4)
+
+/*
+ * The CRC of the frame does not match, the frame is skipped, see
+ * mp3lite_decoder_set_crc()
+ */
+#define MP3LITE_ERR_CRC             (-5)
+
+/* part2_3_length of the frame overruns its main data, the frame is skipped */
+#define MP3LITE_ERR_MAIN_DATA       (-6)
+
+/*
+ * No frame header in the 64 KiB dropped by this pull, the search goes on at
+ * the next pull
+ */
+#define MP3LITE_ERR_SYNC            (-7)
+
+/*
+ * The frame is damaged (any of the errors above that skip a frame), the
+ * decoder wrote concealment output instead, see mp3lite_decoder_set_conceal()
+ */
+#define MP3LITE_CONCEALED           4
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*****************************************************************************
+ *                                                                           *
+ * Output settings                                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Output sample formats */
+#define MP3LITE_FMT_S16             0u  /* Signed 16 bits integer          */
+#define MP3LITE_FMT_S24             1u  /* Signed 24 bits, packed 3 bytes  */
+#define MP3LITE_FMT_F32             2u  /* 32 bits float                   */
+
+/* Output sample layouts */
+#define MP3LITE_LAYOUT_INTERLEAVED  0u  /* L R L R ...                     */
+#define MP3LITE_LAYOUT_PLANAR       1u  /* L L ... R R ...                 */
+
+/* Maximum number of PCM samples per channel in one frame */
+#define MP3LITE_MAX_SAMPLES_PER_FRAME   1152u
+
+/*
+ * Members
+ * -------
+ * fmt          MP3LITE_FMT_S16, MP3LITE_FMT_S24 or MP3LITE_FMT_F32
+ *
+ * layout       MP3LITE_LAYOUT_INTERLEAVED or MP3LITE_LAYOUT_PLANAR
+ *
+ * dither       If 1, TPDF dither is added (MP3LITE_FMT_S16 only)
+ *
+ * mono         If 1, stereo and joint stereo streams are downmixed to one
+ *              channel (dual channel streams are not)
+ */
+typedef struct {
+    uint8_t fmt;
+    uint8_t layout;
+    uint8_t dither;
+    uint8_t mono;
+} mp3lite_output_t;
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Stream and frame information                                              *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Members
+ * -------
+ * ver                  MPEG version, 1, 2 or 25 (2.5)
+ *
+ * layer                3
+ *
+ * mode                 0: stereo
+ *                      1: joint stereo
+ *                      2: dual channel
+ *                      3: single channel
+ *
+ * mode_ext             Joint stereo coding, bit 0: intensity, bit 1: ms
+ *
+ * nch                  Number of channels in the stream (not in the output)
+ *
+ * protection           1 if the frame is CRC protected
+ *
+ * emphasis             0: none, 1: 50/15 ms, 3: CCITT J.17
+ *
+ * bitrate              Bitrate in kbits/s
+ *
+ * freq                 Sampling frequency in Hz
+ *
+ * frame_len            Frame length in bytes, including the header
+ *
+ * samples_per_frame    Number of PCM samples per channel in a frame
+ */
+typedef struct {
+    uint8_t ver;
+    uint8_t layer;
+    uint8_t mode;
+    uint8_t mode_ext;
+    uint8_t nch;
+    uint8_t protection;
+    uint8_t emphasis;
+    uint16_t bitrate;
+    uint32_t freq;
+    uint32_t frame_len;
+    uint32_t samples_per_frame;
+} mp3lite_stream_info_t;
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * Members
+ * -------
+ * info         Stream information from the header of this frame
+ *
+ * offset       Byte offset of the frame header in the fed stream
+ *
+ * nsamples     Number of PCM samples per channel written to the output
+ *              buffer, always 0 for now (see Experimental decoder above)
+ *
+ * crc_error    1 if the frame is protected, its CRC was checked and does
+ *              not match, see mp3lite_decoder_set_crc()
+ */
+typedef struct {
+    mp3lite_stream_info_t info;
+    uint64_t offset;
+    uint32_t nsamples;
+    uint8_t crc_error;
+} mp3lite_frame_t;
+
+/*****************************************************************************
+ *                                                                           *
+ * Streaming decoder                                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Thread safety
+ * -------------
+ * The library has no mutable global or static state, every table is const and
+ * every piece of mutable state is in the decoder context. Functions are
+ * reentrant: different contexts can be used on different threads at the same
+ * time without locking. A single context must not be used by two threads at
+ * the same time
+ *
+ * MP3LITE_DECODER_SIZE is a multiple of 64 bytes, contexts placed back to back
+ * from a 64 bytes aligned block never share a cache line
+ */
+
+/* Opaque decoder context */
+typedef struct mp3lite_decoder mp3lite_decoder_t;
+
+/*
+ * Memory needed for one decoder context, provided by the caller
+ *
+ * The whole decoder state (input buffer, bit reservoir, IMDCT overlap,
+ * synthesis buffers, scratch spectra) lives in this block, the decoder never
+ * calls malloc. MP3LITE_DECODER_SIZE is an upper bound known at compile time,
+ * mp3lite_decoder_size() returns the exact size
+ */
+#define MP3LITE_DECODER_SIZE    32768u
+#define MP3LITE_DECODER_ALIGN   8u
+
+/*
+ * \return  Exact size in bytes of a decoder context,
+ *          never larger than MP3LITE_DECODER_SIZE
+ */
+size_t mp3lite_decoder_size(void);
+
+/*
+ * Initializing a decoder context in caller-provided memory, with interleaved
+ * MP3LITE_FMT_S16 output
+ *
+ * The memory is owned by the caller and can be released or reused without
+ * calling the decoder, no clean up is needed
+ *
+ * \param mem   At least mp3lite_decoder_size() bytes, aligned to
+ *              MP3LITE_DECODER_ALIGN bytes
+ *
+ * \param size  Size of mem in bytes
+ *
+ * \return      The decoder context (at mem), or NULL if mem is NULL, too
+ *              small or not aligned
+ */
+mp3lite_decoder_t *mp3lite_decoder_init(void *mem, const size_t size);
+
+/*
+ * Sets the output format, layout, dither and downmixing, may be called at any
+ * time, it takes effect from the next decoded frame
+ *
+ * \return  MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_set_output(mp3lite_decoder_t *dec,
+                               const mp3lite_output_t *output);
+
+/* CRC policies */
+#define MP3LITE_CRC_SKIP            0u  /* Not checked                     */
+#define MP3LITE_CRC_VERIFY          1u  /* Checked, reported in the frame  */
+#define MP3LITE_CRC_DROP            2u  /* Checked, bad frames are skipped */
+
+/*
+ * Sets how the CRC of protected frames is handled, MP3LITE_CRC_SKIP after
+ * mp3lite_decoder_init()
+ *
+ * The CRC covers the header and the side information, it is checked before
+ * the side information is decoded. A frame dropped by MP3LITE_CRC_DROP is
+ * pulled as MP3LITE_ERR_CRC
+ *
+ * \return  MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_set_crc(mp3lite_decoder_t *dec, const uint8_t policy);
+
+/*
+ * Turns error concealment on (1) or off (0, after mp3lite_decoder_init())
+ *
+ * With concealment, a damaged frame is pulled as MP3LITE_CONCEALED instead
+ * of its error: the spectrum of the last good granule is repeated, faded out
+ * over the next granules and then muted. As the IMDCT and the synthesis are
+ * not implemented (see Experimental decoder), a concealed frame has no output
+ * yet (nsamples is 0). Without concealment, the frame is skipped with its
+ * error
+ *
+ * \return  MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_set_conceal(mp3lite_decoder_t *dec,
+                                const uint8_t conceal);
+
+/*
+ * Pushing bytes of the stream into the decoder, chunks can be of any size
+ * and do not have to be aligned to frames
+ *
+ * An ID3v2 tag at the start of the stream is dropped as it is fed, by its
+ * size and without looking for frames in it
+ *
+ * \return  Number of bytes accepted, which is less than size when the input
+ *          buffer is full; pull frames and feed the rest again
+ */
+size_t mp3lite_decoder_feed(mp3lite_decoder_t *dec,
+                            const uint8_t *data,
+                            const size_t size);
+
+/*
+ * Decoding in place from a buffer that holds the whole stream, e.g. a memory
+ * mapped file, instead of feeding chunks
+ *
+ * Frames and the main data they refer to (main_data_begin) are read directly
+ * from the buffer, nothing is copied into the decoder. The buffer MUST stay
+ * valid and unchanged until another input is set or the decoder is reset.
+ * mp3lite_decoder_feed() accepts nothing in this mode
+ *
+ * ID3v2 tags at the start, and APEv2 and ID3v1 tags at the end, are skipped
+ * by their sizes. The Xing/Info frame is read here, see
+ * mp3lite_decoder_gapless()
+ *
+ * If mp3lite.c is compiled with MP3LITE_USE_MADVISE (POSIX), the buffer is
+ * marked MADV_SEQUENTIAL and MADV_WILLNEED is issued ahead of the decoding
+ * position as it advances
+ *
+ * \param data  The stream, or NULL to go back to feeding chunks
+ *
+ * \param size  Size of data in bytes
+ *
+ * \return      MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_set_input(mp3lite_decoder_t *dec,
+                              const uint8_t *data,
+                              const size_t size);
+
+/*
+ * Seeking to a sample when decoding in place, see
+ * mp3lite_decoder_set_input()
+ *
+ * The frame headers are walked from the start of the buffer to the frame
+ * holding the sample, without decoding. Decoding restarts a few frames
+ * before it, so that main_data_begin of the frame can be satisfied and the
+ * IMDCT overlap and the synthesis are warmed up; those frames are not
+ * returned, the first frame pulled is the one holding the sample
+ *
+ * Seeking is frame accurate for now: the samples of that frame before the
+ * sample are counted, but there is no output to trim them from yet (see
+ * Experimental decoder)
+ *
+ * \param sample   Sample index per channel from the start of the stream,
+ *                 the first sample after the delay with a LAME tag (see
+ *                 mp3lite_decoder_gapless())
+ *
+ * \return         MP3LITE_OK, or MP3LITE_ERR_INVALID_ARG if the decoder is
+ *                 not decoding in place or the sample is past the end
+ */
+int mp3lite_decoder_seek(mp3lite_decoder_t *dec, const uint64_t sample);
+
+/*
+ * Pulling the next frame out of the fed bytes
+ *
+ * \param pcm       Output buffer in the format set by
+ *                  mp3lite_decoder_set_output(), room for
+ *                  MP3LITE_MAX_SAMPLES_PER_FRAME samples per channel
+ *                  May be NULL to skip the PCM output
+ *
+ * \param pcm_size  Size of pcm in bytes
+ *
+ * \param frame     Information of the frame pulled, may be NULL
+ *
+ * \return  MP3LITE_OK:             one frame was decoded
+ *          MP3LITE_NEED_MORE_DATA: no complete frame is buffered
+ *          MP3LITE_CONCEALED:      a damaged frame was concealed
+ *          negative:               the frame was skipped, pull again
+ */
+int mp3lite_decoder_pull(mp3lite_decoder_t *dec,
+                         void *pcm,
+                         const size_t pcm_size,
+                         mp3lite_frame_t *frame);
+
+/*
+ * \return  MP3LITE_OK, or MP3LITE_NEED_MORE_DATA if no frame was decoded yet
+ */
+int mp3lite_decoder_stream_info(const mp3lite_decoder_t *dec,
+                                mp3lite_stream_info_t *info);
+
+/*
+ * Dropping buffered input and the bit reservoir, e.g. after seeking the
+ * input. Output settings and stream information are kept, so is the position
+ * when decoding in place
+ */
+void mp3lite_decoder_flush(mp3lite_decoder_t *dec);
+
+/*
+ * Bringing the decoder back to the state right after
+ * mp3lite_decoder_init(), output settings, the CRC policy and concealment
+ * are kept (the decoder goes back to feeding chunks if it was decoding in
+ * place)
+ */
+void mp3lite_decoder_reset(mp3lite_decoder_t *dec);
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Gapless playback                                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Encoder delay and padding from the LAME tag of the Xing/Info frame
+ *
+ * The Xing/Info frame holds no audio and is never returned by
+ * mp3lite_decoder_pull(). When the LAME tag is present the decoder counts
+ * the first skip samples of the stream to drop and the nsamples samples to
+ * output after them, so that the output is exactly the encoder input. The
+ * samples are to be dropped by writing the output of a frame from an offset;
+ * until there is output (see Experimental decoder) only the counts are kept
+ *
+ * Members
+ * -------
+ * enc_delay    Samples per channel added by the encoder at the start
+ *
+ * enc_padding  Samples per channel added by the encoder at the end
+ *
+ * skip         Samples per channel dropped at the start, enc_delay plus
+ *              the decoder delay (529), 0 without a LAME tag
+ *
+ * nsamples     Playable samples per channel, 0 if unknown
+ */
+typedef struct {
+    uint32_t enc_delay;
+    uint32_t enc_padding;
+    uint32_t skip;
+    uint64_t nsamples;
+} mp3lite_gapless_t;
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * Gapless information of the stream, all 0 if the stream has no Xing/Info
+ * frame
+ *
+ * It is known after mp3lite_decoder_set_input() or
+ * mp3lite_decoder_set_chunk(), or once the first frame is pulled out of fed
+ * bytes. Only the first chunk is trimmed at the start, the trimming restarts
+ * after mp3lite_decoder_seek()
+ *
+ * \return  MP3LITE_OK, MP3LITE_NEED_MORE_DATA if the first frame was not
+ *          pulled yet, or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_gapless(const mp3lite_decoder_t *dec,
+                            mp3lite_gapless_t *gapless);
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Splitting a stream into chunks                                            *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * A run of frames of a stream held in memory, that can be decoded on its own
+ * (e.g. one chunk per thread, each thread with its own context)
+ *
+ * Decoding starts a few frames before the chunk (the pre-roll), so that the
+ * main data the first frames refer to (main_data_begin) is in the bit
+ * reservoir and the IMDCT overlap and the synthesis are warmed up. The output
+ * of the pre-roll frames is discarded by the decoder, the frames of
+ * consecutive chunks join sample-exactly
+ *
+ * Members
+ * -------
+ * preroll_offset   Byte offset of the first pre-roll frame
+ *
+ * offset           Byte offset of the first frame of the chunk, equal to the
+ *                  end of the previous chunk
+ *
+ * end              Byte offset one past the chunk, the offset of the next
+ *                  chunk or the size of the stream
+ *
+ * preroll_frames   Number of frames in [preroll_offset, offset)
+ *
+ * nframes          Number of frames in [offset, end)
+ */
+typedef struct {
+    size_t preroll_offset;
+    size_t offset;
+    size_t end;
+    uint32_t preroll_frames;
+    uint32_t nframes;
+} mp3lite_chunk_t;
+
+/*
+ * Splitting a stream into at most max_chunks chunks of about the same number
+ * of frames, at frame boundaries
+ *
+ * The stream is scanned twice, only the headers and main_data_begin are read.
+ * The Xing/Info frame holds no audio and is in no chunk, the first chunk
+ * starts after it
+ *
+ * \param data         The whole stream
+ *
+ * \param size         Size of data in bytes
+ *
+ * \param chunks       max_chunks chunks, filled in stream order
+ *
+ * \return             Number of chunks, 0 if there is no complete frame
+ */
+uint32_t mp3lite_split(const uint8_t *data,
+                       const size_t size,
+                       mp3lite_chunk_t *chunks,
+                       const uint32_t max_chunks);
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*
+ * Decoding one chunk in place, like mp3lite_decoder_set_input()
+ *
+ * mp3lite_decoder_pull() decodes the pre-roll frames without output and
+ * returns the frames of the chunk only, frame offsets are offsets in data.
+ * MP3LITE_NEED_MORE_DATA is returned at the end of the chunk
+ *
+ * \param data     The whole stream, as given to mp3lite_split()
+ *
+ * \param size     Size of data in bytes
+ *
+ * \param chunk    One of the chunks from mp3lite_split()
+ *
+ * \return         MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_decoder_set_chunk(mp3lite_decoder_t *dec,
+                              const uint8_t *data,
+                              const size_t size,
+                              const mp3lite_chunk_t *chunk);
+
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Cutting a stream                                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Members
+ * -------
+ * offset       Byte offset in data of the first kept frame, the frame
+ *              holding the first sample
+ *
+ * end          Byte offset in data one past the last kept frame
+ *
+ * nframes      Number of kept frames, copied as they are
+ *
+ * ncarried     Number of carrier frames written before the kept frames, the
+ *              frames before offset whose main data slots hold main data of
+ *              the kept frames (main_data_begin > 0). They are silent, only
+ *              their slots are kept
+ *
+ * skip         Samples per channel to drop at the start of the cut to start
+ *              exactly at the first sample (the carriers included)
+ *
+ * padding      Samples per channel to drop at the end of the cut to stop
+ *              exactly after nsamples samples
+ *
+ * nsamples     Samples per channel of the whole cut
+ *
+ * len          Length of the cut in bytes
+ */
+typedef struct {
+    size_t offset;
+    size_t end;
+    uint32_t nframes;
+    uint32_t ncarried;
+    uint32_t skip;
+    uint32_t padding;
+    uint64_t nsamples;
+    size_t len;
+} mp3lite_cut_t;
+
+/*
+ * Cutting a time range out of a stream held in memory as a valid stream of
+ * whole frames, without decoding
+ *
+ * Frames are located from their headers and main_data_begin only. The cut
+ * starts with main_data_begin 0, so it decodes on its own and cuts can be
+ * spliced back to back. Samples are counted as in mp3lite_decoder_seek(),
+ * the Xing/Info frame is not copied
+ *
+ * \param data      The whole stream
+ *
+ * \param size      Size of data in bytes
+ *
+ * \param sample    First sample per channel of the range
+ *
+ * \param nsamples  Number of samples per channel of the range, the cut is
+ *                  shorter if the stream ends before
+ *
+ * \param dest      Output buffer of at least cut->len bytes, may be NULL to
+ *                  only fill cut
+ *
+ * \param dest_size Size of dest in bytes
+ *
+ * \param cut       Where the cut is in data and how to trim it
+ *
+ * \return          MP3LITE_OK, or MP3LITE_ERR_INVALID_ARG if the sample is
+ *                  past the end or dest is too small (cut is filled)
+ */
+int mp3lite_cut(const uint8_t *data,
+                const size_t size,
+                const uint64_t sample,
+                const uint64_t nsamples,
+                uint8_t *dest,
+                const size_t dest_size,
+                mp3lite_cut_t *cut);
+
+/*****************************************************************************
+ *                                                                           *
+ * Gain adjustment                                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Members
+ * -------
+ * nframes      Number of frames rewritten
+ *
+ * nclipped     Number of global_gain values clamped to 0 or 255
+ *
+ * ncrc_error   Number of protected frames whose CRC did not match, it is
+ *              left mismatching
+ */
+typedef struct {
+    uint64_t nframes;
+    uint64_t nclipped;
+    uint64_t ncrc_error;
+} mp3lite_gain_t;
+
+/*
+ * Changing the volume of a stream held in memory in place, without decoding
+ *
+ * step is added to global_gain of every granule and channel, one step is
+ * 1.5 dB. Only those 8 bits of the side information (and the CRC of
+ * protected frames) are rewritten, the main data is not touched and the
+ * length of the stream does not change. The Xing/Info frame is left as it is
+ *
+ * \param data     The whole stream
+ *
+ * \param size     Size of data in bytes
+ *
+ * \param step     Gain in 1.5 dB steps, -255 to 255
+ *
+ * \param gain     Statistics of the rewrite
+ *
+ * \return         MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_apply_gain(uint8_t *data,
+                       const size_t size,
+                       const int32_t step,
+                       mp3lite_gain_t *gain);
+
+/*****************************************************************************
+ *                                                                           *
+ * Silence estimation                                                        *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Flags of mp3lite_silence_cfg_t */
+#define MP3LITE_SILENCE_LOW     0x01u   /* Low-activity frames are silent */
+
+/*
+ * Members
+ * -------
+ * threshold    Level in dBFS below which a granule is silent, e.g. -60.0
+ *
+ * low_bits     part2_3_length (bits of a granule and channel) at or below
+ *              which a granule above threshold is low-activity, e.g. 100
+ *
+ * min_len      Shortest silence reported as a segment, in samples per
+ *              channel; the leading and trailing silence are trimmed
+ *              whatever their length
+ *
+ * flags        0 or MP3LITE_SILENCE_LOW
+ */
+typedef struct {
+    double threshold;
+    uint32_t low_bits;
+    uint64_t min_len;
+    uint32_t flags;
+} mp3lite_silence_cfg_t;
+
+/*
+ * Members
+ * -------
+ * start    First sample per channel of the segment
+ *
+ * len      Number of samples per channel
+ */
+typedef struct {
+    uint64_t start;
+    uint64_t len;
+} mp3lite_segment_t;
+
+/*
+ * Members
+ * -------
+ * nframes      Number of frames
+ *
+ * nsilent      Number of silent frames
+ *
+ * nlow         Number of low-activity frames, counted as silent with
+ *              MP3LITE_SILENCE_LOW
+ *
+ * nsamples     Samples per channel of the stream
+ *
+ * trim_start   First sample per channel after the leading silence
+ *
+ * trim_end     Sample per channel one past the end of the audio, before the
+ *              trailing silence; trim_start and trim_end are 0 if the whole
+ *              stream is silent
+ *
+ * nsegments    Number of silence segments, it may be more than max_segments
+ */
+typedef struct {
+    uint64_t nframes;
+    uint64_t nsilent;
+    uint64_t nlow;
+    uint64_t nsamples;
+    uint64_t trim_start;
+    uint64_t trim_end;
+    uint64_t nsegments;
+} mp3lite_silence_t;
+
+/*
+ * Estimating silence in a stream held in memory from the side information
+ * alone, without decoding
+ *
+ * A frame is silent if global_gain, big_values and the Huffman tables of
+ * every granule and channel bound its coefficients below cfg->threshold
+ * (or if part2_3_length is 0). Frames above it with few bits are
+ * low-activity: the bound is loose for them, they are mostly quiet noise
+ * floors. Segments and trim points are frame accurate, samples are counted
+ * as in mp3lite_decoder_seek(), so the audio between the trim points can be
+ * cut out with mp3lite_cut()
+ *
+ * The result is an estimate: the level of a frame is an upper bound from
+ * the side information, no frame is decoded to confirm it. Low-activity
+ * frames are not checked against their decoded level, MP3LITE_SILENCE_LOW
+ * decides for all of them
+ *
+ * \param data          The whole stream
+ *
+ * \param size          Size of data in bytes
+ *
+ * \param cfg           Thresholds
+ *
+ * \param segments      Runs of silent frames, in stream order, may be NULL
+ *                      if max_segments is 0
+ *
+ * \param max_segments  Number of segments segments has room for
+ *
+ * \param silence       Statistics and trim points of the stream
+ *
+ * \return              MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_estimate_silence(const uint8_t *data,
+                             const size_t size,
+                             const mp3lite_silence_cfg_t *cfg,
+                             mp3lite_segment_t *segments,
+                             const uint32_t max_segments,
+                             mp3lite_silence_t *silence);
+
+/*****************************************************************************
+ *                                                                           *
+ * Scanning a stream                                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Flags of mp3lite_scan() */
+#define MP3LITE_SCAN_SIDE_INFO  0x01u   /* Also decode the side information */
+
+/*
+ * Statistics of a stream, from the frame headers (and side information)
+ *
+ * Members
+ * -------
+ * nframes          Number of complete frames, without the Xing/Info frame
+ *
+ * nsamples         Number of PCM samples per channel in the frames, without
+ *                  the encoder delay and padding if the stream has a LAME
+ *                  tag (see mp3lite_gapless_t). The exact duration is
+ *                  nsamples / freq seconds
+ *
+ * freq             Sampling frequency of the first frame in Hz
+ *
+ * bitrate_min      Lowest frame bitrate in kbits/s
+ *
+ * bitrate_max      Highest frame bitrate in kbits/s
+ *
+ * bitrate_avg      Average bitrate in kbits/s (frame bytes over duration)
+ *
+ * vbr              0 if every frame has the same bitrate (CBR), 1 otherwise
+ *
+ * bitrate_hist     Number of frames per bitrate index of the header, 1 to 14
+ *
+ * mode             Number of frames per channel mode,
+ *                  see mp3lite_stream_info_t
+ *
+ * mode_ext         Number of joint stereo frames per mode_ext
+ *
+ * block_type       Number of granules per block type and channel,
+ *                  0: normal, 1: start, 2: short, 3: stop
+ *                  (MP3LITE_SCAN_SIDE_INFO only)
+ *
+ * mixed_block      Number of granules per channel with mixed blocks
+ *                  (MP3LITE_SCAN_SIDE_INFO only)
+ *
+ * side_info_err    Number of frames with invalid side information
+ *                  (MP3LITE_SCAN_SIDE_INFO only)
+ *
+ * junk_len         Number of bytes that are not part of a complete frame,
+ *                  tags excluded
+ *
+ * tag_len          Number of bytes in the ID3v2 tags and the Xing/Info frame
+ *                  at the start and in the APEv2/ID3v1 tags at the end, which
+ *                  are skipped
+ */
+typedef struct {
+    uint64_t nframes;
+    uint64_t nsamples;
+    uint32_t freq;
+    uint16_t bitrate_min;
+    uint16_t bitrate_max;
+    uint16_t bitrate_avg;
+    uint8_t vbr;
+    uint64_t bitrate_hist[16];
+    uint64_t mode[4];
+    uint64_t mode_ext[4];
+    uint64_t block_type[4];
+    uint64_t mixed_block;
+    uint64_t side_info_err;
+    uint64_t junk_len;
+    uint64_t tag_len;
+} mp3lite_scan_t;
+
+/*
+ * Walking every frame of a stream held in memory without decoding it,
+ * only the frame headers are read (and the side information with
+ * MP3LITE_SCAN_SIDE_INFO), the main data is never touched
+ *
+ * \param data     The whole stream
+ *
+ * \param size     Size of data in bytes
+ *
+ * \param flags    0 or MP3LITE_SCAN_SIDE_INFO
+ *
+ * \param scan     Statistics of the stream
+ *
+ * \return         MP3LITE_OK or MP3LITE_ERR_INVALID_ARG
+ */
+int mp3lite_scan(const uint8_t *data,
+                 const size_t size,
+                 const uint32_t flags,
+                 mp3lite_scan_t *scan);
+
+#if defined (MP3LITE_EXPERIMENTAL_DECODER)
+
+/*****************************************************************************
+ *                                                                           *
+ * File reader                                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+/*
+ * Reading a file with a queue of large reads in flight and feeding the
+ * decoder from them, so the reads overlap the decoding
+ *
+ * Only available if mp3lite.c is compiled with MP3LITE_USE_PREAD (POSIX
+ * pread) or MP3LITE_USE_IO_URING (Linux io_uring, without liburing). With
+ * io_uring every block has a read in flight; if io_uring cannot be set up or
+ * does not support reads, the blocks are read with pread when they are
+ * needed
+ *
+ * Like the decoder, the reader lives in caller-provided memory
+ */
+
+/* Opaque reader */
+typedef struct mp3lite_reader mp3lite_reader_t;
+
+/* Maximum number of blocks of a reader */
+#define MP3LITE_READER_BLOCKS_MAX   32u
+
+/*
+ * \return  Size in bytes of the memory needed for a reader of nblocks blocks
+ *          of block_len bytes
+ */
+size_t mp3lite_reader_size(const uint32_t block_len, const uint32_t nblocks);
+
+/*
+ * Initializing a reader and queueing the reads of the first blocks
+ *
+ * \param mem          At least mp3lite_reader_size() bytes, aligned to
+ *                     MP3LITE_DECODER_ALIGN bytes, owned by the caller until
+ *                     mp3lite_reader_close()
+ *
+ * \param size         Size of mem in bytes
+ *
+ * \param fd           File descriptor opened for reading, not closed by the
+ *                     reader
+ *
+ * \param offset       File offset of the first byte to feed
+ *
+ * \param block_len    Size of a read in bytes, e.g. 256 KiB
+ *
+ * \param nblocks      Number of blocks, 2 to MP3LITE_READER_BLOCKS_MAX
+ *
+ * \return             The reader (at mem), or NULL if an argument is invalid
+ */
+mp3lite_reader_t *mp3lite_reader_init(void *mem,
+                                      const size_t size,
+                                      const int fd,
+                                      const uint64_t offset,
+                                      const uint32_t block_len,
+                                      const uint32_t nblocks);
+
+/*
+ * Feeding the decoder with the blocks already read, blocks used up are
+ * queued again further in the file
+ *
+ * Call it when mp3lite_decoder_pull() returns MP3LITE_NEED_MORE_DATA, it only
+ * waits for a read if nothing could be fed
+ *
+ * \return  MP3LITE_OK:             bytes were fed, or the decoder is full
+ *          MP3LITE_END_OF_STREAM:  everything up to the end of the file was
+ *                                  fed
+ *          MP3LITE_ERR_IO:         a read failed, errno is set
+ */
+int mp3lite_reader_feed(mp3lite_reader_t *reader, mp3lite_decoder_t *dec);
+
+/*
+ * Waiting for the reads in flight and releasing the io_uring, mem can be
+ * released after this call
+ */
+void mp3lite_reader_close(mp3lite_reader_t *reader);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* MP3LITE_H */
\ No newline at end of file
+#endif /* MP3LITE_H */
@@ -0,0 +1,174 @@
+#ifndef TEST_FRAMES_H
+#define TEST_FRAMES_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Helpers for building synthetic MPEG-1 and MPEG-2 Layer 3 frames
+ *
+ * The frames have valid headers and side information, the main data is
+ * filled with a constant byte, so they can be scanned and parsed but they do
+ * not decode to meaningful audio
+ */
+
+/* 128 kbits/s, 44100 Hz, no padding, no CRC */
+#define TEST_FRAME_LEN 417u
+
+/*
+ * \param buf               At least TEST_FRAME_LEN bytes
+ *
+ * \param mode              Channel mode, 0 to 3
+ *
+ * \param main_data_begin   Written into the side information, 9 bits
+ *
+ * \param fill              Value of every main data byte
+ *
+ * \return                  Frame length in bytes
+ */
+static uint32_t s_test_make_frame(uint8_t *buf,
+                                  const uint8_t mode,
+                                  const uint16_t main_data_begin,
+                                  const uint8_t fill)
+{
+    const uint32_t side_info_len = (mode == 3u) ? 17u : 32u;
+
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 1111 1111 1111 1011 1001 0000 II00 0000 */
+    buf[0] = 0xFF;
+    buf[1] = 0xFB;
+    buf[2] = 0x90;
+    buf[3] = (uint8_t) (mode << 6);
+
+    memset(&buf[4], 0, side_info_len);
+    buf[4] = (uint8_t) (main_data_begin >> 1);
+    buf[5] = (uint8_t) ((main_data_begin & 0x01u) << 7);
+
+    memset(&buf[4u + side_info_len], fill,
+           TEST_FRAME_LEN - 4u - side_info_len);
+
+    return TEST_FRAME_LEN;
+}
+
+
+/*
+ * CRC-16 of ISO/IEC 11172-3, bit by bit
+ *
+ * \param crc   CRC of the preceding bytes, 0xFFFF at the start
+ */
+static uint16_t s_test_crc16(uint16_t crc,
+                             const uint8_t *data,
+                             const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        for (uint8_t bit = 0; bit < 8u; ++bit)
+        {
+            uint16_t in = (uint16_t) ((data[i] >> (7u - bit)) & 0x01u);
+            uint16_t msb = (uint16_t) (crc >> 15);
+
+            crc = (uint16_t) (crc << 1);
+            crc = (msb ^ in) ? (uint16_t) (crc ^ 0x8005u) : crc;
+        }
+    }
+
+    return crc;
+}
+
+
+/*
+ * Same as s_test_make_frame(), with a CRC, the main data is 2 bytes shorter
+ */
+static uint32_t s_test_make_protected_frame(uint8_t *buf,
+                                            const uint8_t mode,
+                                            const uint16_t main_data_begin,
+                                            const uint8_t fill)
+{
+    const uint32_t side_info_len = (mode == 3u) ? 17u : 32u;
+    uint8_t frame[TEST_FRAME_LEN];
+
+    (void) s_test_make_frame(frame, mode, main_data_begin, fill);
+
+    memcpy(buf, frame, 4);
+    buf[1] = 0xFA;
+    memcpy(&buf[6], &frame[4], TEST_FRAME_LEN - 6u);
+
+    uint16_t crc = s_test_crc16(0xFFFFu, &buf[2], 2);
+    crc = s_test_crc16(crc, &buf[6], side_info_len);
+    buf[4] = (uint8_t) (crc >> 8);
+    buf[5] = (uint8_t) crc;
+
+    return TEST_FRAME_LEN;
+}
+
+
+/*
+ * Same as s_test_make_frame() in mono, with an "Info" tag in place of the
+ * main data (frames, bytes, TOC and quality fields) and a LAME tag
+ *
+ * \param nframes   Number of audio frames after this one
+ *
+ * \param delay     Encoder delay, 12 bits
+ *
+ * \param padding   Encoder padding, 12 bits
+ */
+static uint32_t s_test_make_info_frame(uint8_t *buf,
+                                       const uint32_t nframes,
+                                       const uint16_t delay,
+                                       const uint16_t padding)
+{
+    (void) s_test_make_frame(buf, 3, 0, 0);
+
+    /* After the header and the 17 bytes of mono side information */
+    uint8_t *tag = &buf[21];
+    memcpy(tag, "Info", 4);
+    tag[7] = 0x0F;
+    tag[8] = (uint8_t) (nframes >> 24);
+    tag[9] = (uint8_t) (nframes >> 16);
+    tag[10] = (uint8_t) (nframes >> 8);
+    tag[11] = (uint8_t) nframes;
+
+    /* After the bytes, TOC and quality fields */
+    uint8_t *lame = &tag[8u + 4u + 4u + 100u + 4u];
+    memcpy(lame, "LAME3.100", 9);
+    lame[21] = (uint8_t) (delay >> 4);
+    lame[22] = (uint8_t) (((delay & 0x0Fu) << 4) | (padding >> 8));
+    lame[23] = (uint8_t) padding;
+
+    return TEST_FRAME_LEN;
+}
+
+/* MPEG-2, 64 kbits/s, 22050 Hz, no padding, no CRC */
+#define TEST_LSF_FRAME_LEN 208u
+
+/*
+ * Same as s_test_make_frame(), for a single granule MPEG-2 frame
+ *
+ * \param buf               At least TEST_LSF_FRAME_LEN bytes
+ *
+ * \param main_data_begin   Written into the side information, 8 bits
+ */
+static uint32_t s_test_make_lsf_frame(uint8_t *buf,
+                                      const uint8_t mode,
+                                      const uint8_t main_data_begin,
+                                      const uint8_t fill)
+{
+    const uint32_t side_info_len = (mode == 3u) ? 9u : 17u;
+
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 1111 1111 1111 0011 1000 0000 II00 0000 */
+    buf[0] = 0xFF;
+    buf[1] = 0xF3;
+    buf[2] = 0x80;
+    buf[3] = (uint8_t) (mode << 6);
+
+    memset(&buf[4], 0, side_info_len);
+    buf[4] = main_data_begin;
+
+    memset(&buf[4u + side_info_len], fill,
+           TEST_LSF_FRAME_LEN - 4u - side_info_len);
+
+    return TEST_LSF_FRAME_LEN;
+}
+
+#endif
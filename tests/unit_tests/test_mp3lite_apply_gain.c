@@ -0,0 +1,190 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES 8u
+
+static uint8_t s_stream[(NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+static uint8_t s_original[(NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+
+
+/*
+ * \return  true if every global_gain of the frames in data[0, len) is gain
+ */
+static bool s_gain_check(const uint8_t *data,
+                         const uint32_t len,
+                         const uint8_t gain)
+{
+    header_info_t header_info;
+    side_info_t side_info;
+    size_t pos = 0;
+    bool success = true;
+
+    while (s_next_frame(data, len, &pos, &header_info))
+    {
+        const uint32_t crc_len = (header_info.protection) ? CRC_LEN : 0;
+        const uint8_t nch = (header_info.mode == 3u) ? 1u : 2u;
+
+        success = success &&
+                  (s_decode_side_info(&data[pos + HEADER_LEN + crc_len],
+                                      &side_info, &header_info) == 0u);
+
+        for (uint8_t gr = 0; gr < s_num_granules(&header_info); ++gr)
+        {
+            for (uint8_t ch = 0; ch < nch; ++ch)
+            {
+                success = success &&
+                          (side_info.gr_ch[s_gr_ch_idx(gr, ch)].global_gain ==
+                           gain);
+            }
+        }
+
+        pos += s_frame_len(&header_info);
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing MPEG-1 stereo and mono frames, only global_gain changes and it is
+ * clamped
+ */
+static bool s_test_apply_gain_t0(void)
+{
+    mp3lite_gain_t gain;
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], (uint8_t) (i % 4u),
+                                 (uint16_t) (i * 10u), (uint8_t) i);
+    }
+    memcpy(s_original, s_stream, len);
+
+    /* Four [gr][ch] in the stereo frames, two in the mono frames */
+    bool success = (mp3lite_apply_gain(s_stream, len, 10, &gain) ==
+                    MP3LITE_OK) &&
+                   (gain.nframes == NUM_FRAMES) && (gain.nclipped == 0u) &&
+                   s_gain_check(s_stream, len, 10);
+
+    success = success &&
+              (mp3lite_apply_gain(s_stream, len, -20, &gain) == MP3LITE_OK) &&
+              (gain.nclipped == (6u * 4u + 2u * 2u)) &&
+              s_gain_check(s_stream, len, 0) &&
+              (memcmp(s_stream, s_original, len) == 0);
+
+    success = success &&
+              (mp3lite_apply_gain(s_stream, len, 255, &gain) == MP3LITE_OK) &&
+              (mp3lite_apply_gain(s_stream, len, 1, &gain) == MP3LITE_OK) &&
+              (gain.nclipped == (6u * 4u + 2u * 2u)) &&
+              s_gain_check(s_stream, len, 255);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing protected frames, MPEG-2 frames and a Xing/Info frame
+ */
+static bool s_test_apply_gain_t1(void)
+{
+    header_info_t header_info;
+    mp3lite_gain_t gain;
+    uint32_t len = s_test_make_info_frame(s_stream, NUM_FRAMES, 576, 1000);
+
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_protected_frame(&s_stream[len], (uint8_t) (i % 4u),
+                                           0, (uint8_t) i);
+    }
+
+    /* The CRC of the last frame is damaged and stays so */
+    s_stream[len - TEST_FRAME_LEN + 4u] ^= 0x01u;
+    memcpy(s_original, s_stream, TEST_FRAME_LEN);
+
+    bool success = (mp3lite_apply_gain(s_stream, len, 7, &gain) ==
+                    MP3LITE_OK) &&
+                   (gain.nframes == NUM_FRAMES) && (gain.ncrc_error == 1u) &&
+                   s_gain_check(&s_stream[TEST_FRAME_LEN],
+                                len - TEST_FRAME_LEN, 7) &&
+                   (memcmp(s_stream, s_original, TEST_FRAME_LEN) == 0);
+
+    for (uint32_t i = 1; i <= NUM_FRAMES; ++i)
+    {
+        const uint8_t *frame_ptr = &s_stream[i * TEST_FRAME_LEN];
+        success = success && s_frame_header_valid(frame_ptr, &header_info) &&
+                  (s_frame_crc_ok(frame_ptr, &header_info) ==
+                   (i < NUM_FRAMES));
+    }
+
+    len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_lsf_frame(&s_stream[len], (uint8_t) (i % 4u), 0,
+                                     (uint8_t) i);
+    }
+
+    success = success &&
+              (mp3lite_apply_gain(s_stream, len, 100, &gain) == MP3LITE_OK) &&
+              (gain.nframes == NUM_FRAMES) &&
+              s_gain_check(s_stream, len, 100);
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing invalid arguments
+ */
+static bool s_test_apply_gain_t2(void)
+{
+    mp3lite_gain_t gain;
+
+    return (mp3lite_apply_gain(NULL, 0, 1, &gain) ==
+            MP3LITE_ERR_INVALID_ARG) &&
+           (mp3lite_apply_gain(s_stream, 0, 1, NULL) ==
+            MP3LITE_ERR_INVALID_ARG) &&
+           (mp3lite_apply_gain(s_stream, 0, 256, &gain) ==
+            MP3LITE_ERR_INVALID_ARG) &&
+           (mp3lite_apply_gain(s_stream, 0, -256, &gain) ==
+            MP3LITE_ERR_INVALID_ARG) &&
+           (mp3lite_apply_gain(s_stream, 0, -255, &gain) == MP3LITE_OK) &&
+           (gain.nframes == 0u);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_apply_gain_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_apply_gain_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_apply_gain_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,239 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES 20u
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[(NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+static uint8_t s_cut[2u * (NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+
+
+/* FNV-1a */
+static uint64_t s_hash(uint64_t hash, const uint8_t *data, const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3u;
+    }
+
+    return hash;
+}
+
+
+/*
+ * Mono frames, main_data_begin reaches two slots back from the third frame
+ */
+static uint32_t s_make_stream(uint8_t *buf, const bool protection)
+{
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint16_t main_data_begin = (i < 2u) ? 0u : 500u;
+        len += (protection) ?
+               s_test_make_protected_frame(&buf[len], 3, main_data_begin,
+                                           (uint8_t) i) :
+               s_test_make_frame(&buf[len], 3, main_data_begin, (uint8_t) i);
+    }
+
+    return len;
+}
+
+
+/*
+ * Decoding data and hashing the main data of every frame
+ *
+ * \return  Number of frames, 0 if one was not MP3LITE_OK
+ */
+static uint32_t s_decode(const uint8_t *data,
+                         const uint32_t len,
+                         uint64_t *hashes)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    int result = MP3LITE_OK;
+    uint32_t n = 0;
+    bool ok_b = true;
+
+    (void) mp3lite_decoder_set_crc(dec, MP3LITE_CRC_DROP);
+    (void) mp3lite_decoder_set_input(dec, data, len);
+
+    while ((result = mp3lite_decoder_pull(dec, NULL, 0, NULL)) !=
+           MP3LITE_NEED_MORE_DATA)
+    {
+        uint64_t hash = 0xCBF29CE484222325u;
+        for (uint32_t j = 0; j < dec->main_data.nseg; ++j)
+        {
+            hash = s_hash(hash, dec->main_data.seg_ptr[j],
+                          dec->main_data.seg_len[j]);
+        }
+
+        hashes[n] = hash;
+        ok_b = ok_b && (result == MP3LITE_OK);
+        ++n;
+    }
+
+    return (ok_b) ? n : 0;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing a cut in the middle of the stream, the carriers hold the main data
+ * of the first kept frame and the cut decodes to the same main data
+ */
+static bool s_test_cut_t0(void)
+{
+    const uint32_t len = s_make_stream(s_stream, false);
+    uint64_t expected[NUM_FRAMES];
+    uint64_t hashes[NUM_FRAMES];
+    mp3lite_cut_t cut;
+
+    bool success = (mp3lite_cut(s_stream, len, (5u * 1152u) + 100u,
+                                3u * 1152u, s_cut, sizeof(s_cut), &cut) ==
+                    MP3LITE_OK) &&
+                   (cut.offset == (5u * TEST_FRAME_LEN)) &&
+                   (cut.end == (9u * TEST_FRAME_LEN)) &&
+                   (cut.nframes == 4u) && (cut.ncarried == 2u) &&
+                   (cut.skip == (100u + (2u * 1152u))) &&
+                   (cut.padding == ((4u * 1152u) - 100u - (3u * 1152u))) &&
+                   (cut.nsamples == (6u * 1152u)) &&
+                   (cut.len == (6u * TEST_FRAME_LEN));
+
+    /* Silent carriers with the slots of frames 3 and 4, then frames 5 to 8 */
+    const uint8_t zeros[17] = {0};
+    success = success &&
+              (memcmp(&s_cut[4], zeros, 17) == 0) &&
+              (memcmp(&s_cut[21], &s_stream[(3u * TEST_FRAME_LEN) + 21u],
+                      TEST_FRAME_LEN - 21u) == 0) &&
+              (memcmp(&s_cut[TEST_FRAME_LEN + 4u], zeros, 17) == 0) &&
+              (memcmp(&s_cut[2u * TEST_FRAME_LEN],
+                      &s_stream[5u * TEST_FRAME_LEN],
+                      4u * TEST_FRAME_LEN) == 0);
+
+    success = success &&
+              (s_decode(s_stream, len, expected) == NUM_FRAMES) &&
+              (s_decode(s_cut, (uint32_t) cut.len, hashes) == 6u);
+
+    for (uint32_t i = 0; success && (i < 4u); ++i)
+    {
+        success = (hashes[2u + i] == expected[5u + i]);
+    }
+
+    /* Frame 1 has main_data_begin 0, nothing is carried */
+    success = success &&
+              (mp3lite_cut(s_stream, len, 1152u, 1u, NULL, 0, &cut) ==
+               MP3LITE_OK) &&
+              (cut.ncarried == 0u) && (cut.nframes == 1u) &&
+              (cut.skip == 0u) && (cut.padding == 1151u);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing protected frames, a Xing/Info frame and two cuts spliced together
+ */
+static bool s_test_cut_t1(void)
+{
+    uint32_t len = s_make_stream(s_stream, true);
+    uint64_t hashes[2u * NUM_FRAMES];
+    mp3lite_cut_t cut_0;
+    mp3lite_cut_t cut_1;
+
+    /* The CRC of the carriers is rewritten */
+    bool success = (mp3lite_cut(s_stream, len, 10u * 1152u, 2u * 1152u,
+                                s_cut, sizeof(s_cut), &cut_0) ==
+                    MP3LITE_OK) &&
+                   (cut_0.ncarried == 2u) &&
+                   (mp3lite_cut(s_stream, len, 3u * 1152u, 1152u,
+                                &s_cut[cut_0.len], sizeof(s_cut) - cut_0.len,
+                                &cut_1) == MP3LITE_OK) &&
+                   (cut_1.ncarried == 2u) &&
+                   (s_decode(s_cut, (uint32_t) (cut_0.len + cut_1.len),
+                             hashes) ==
+                    (cut_0.ncarried + cut_0.nframes + cut_1.ncarried +
+                     cut_1.nframes));
+
+    /* Samples are counted from the end of the delay */
+    len = s_test_make_info_frame(s_stream, NUM_FRAMES, 576, 1000);
+    len += s_make_stream(&s_stream[len], false);
+    success = success &&
+              (mp3lite_cut(s_stream, len, 0, 1, s_cut, sizeof(s_cut),
+                           &cut_0) == MP3LITE_OK) &&
+              (cut_0.offset == TEST_FRAME_LEN) && (cut_0.ncarried == 0u) &&
+              (cut_0.skip == (576u + DECODER_DELAY)) &&
+              (memcmp(s_cut, &s_stream[TEST_FRAME_LEN], TEST_FRAME_LEN) == 0);
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing the end of the stream and invalid arguments
+ */
+static bool s_test_cut_t2(void)
+{
+    const uint32_t len = s_make_stream(s_stream, false);
+    mp3lite_cut_t cut;
+
+    bool success = (mp3lite_cut(s_stream, len, (NUM_FRAMES - 1u) * 1152u,
+                                10u * 1152u, NULL, 0, &cut) == MP3LITE_OK) &&
+                   (cut.nframes == 1u) && (cut.padding == 0u) &&
+                   (cut.end == len) &&
+                   (mp3lite_cut(s_stream, len, NUM_FRAMES * 1152u, 1, NULL,
+                                0, &cut) == MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_cut(s_stream, len, 0, 0, NULL, 0, &cut) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_cut(NULL, len, 0, 1, NULL, 0, &cut) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_cut(s_stream, len, 0, 1, NULL, 0, NULL) ==
+                    MP3LITE_ERR_INVALID_ARG);
+
+    /* cut is filled when dest is too small */
+    success = success &&
+              (mp3lite_cut(s_stream, len, 5u * 1152u, 1, s_cut,
+                           (3u * TEST_FRAME_LEN) - 1u, &cut) ==
+               MP3LITE_ERR_INVALID_ARG) &&
+              (cut.len == (3u * TEST_FRAME_LEN));
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_cut_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_cut_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_cut_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,323 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+
+/*
+ * TEST_0
+ *
+ * Testing feeding small chunks and pulling frames, with garbage before the
+ * first frame
+ */
+static bool s_test_decoder_t0(void)
+{
+    static uint8_t stream[7u + 3u * TEST_FRAME_LEN];
+    memset(stream, 0xFF, 7);
+
+    uint32_t len = 7;
+    for (uint8_t i = 0; i < 3u; ++i)
+    {
+        len += s_test_make_frame(&stream[len], 1, 0, i);
+    }
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    if (!dec)
+    {
+        return false;
+    }
+
+    mp3lite_stream_info_t info;
+    bool no_info_b = (mp3lite_decoder_stream_info(dec, &info) ==
+                      MP3LITE_NEED_MORE_DATA);
+
+    uint32_t pos = 0;
+    uint32_t nframes = 0;
+    bool offset_b = true;
+    mp3lite_frame_t frame;
+
+    while (pos < len)
+    {
+        size_t chunk = ((len - pos) < 13u) ? (len - pos) : 13u;
+        pos += (uint32_t) mp3lite_decoder_feed(dec, &stream[pos], chunk);
+
+        while (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK)
+        {
+            offset_b = offset_b &&
+                       (frame.offset == (7u + nframes * TEST_FRAME_LEN));
+            ++nframes;
+        }
+    }
+
+    bool info_b = (mp3lite_decoder_stream_info(dec, &info) == MP3LITE_OK) &&
+                  (info.ver == 1u) && (info.layer == 3u) &&
+                  (info.mode == 1u) && (info.nch == 2u) &&
+                  (info.bitrate == 128u) && (info.freq == 44100u) &&
+                  (info.frame_len == TEST_FRAME_LEN) &&
+                  (info.samples_per_frame == 1152u);
+
+    return no_info_b && offset_b && info_b && (nframes == 3u);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the bit reservoir, the main data of the second frame begins
+ * 10 bytes before its own main data slot
+ */
+static bool s_test_decoder_t1(void)
+{
+    static uint8_t stream[2u * TEST_FRAME_LEN];
+
+    uint32_t len = s_test_make_frame(stream, 3, 0, 0xAA);
+    len += s_test_make_frame(&stream[len], 3, 10, 0xBB);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    if (!dec)
+    {
+        return false;
+    }
+
+    (void) mp3lite_decoder_feed(dec, stream, len);
+
+    bool f0_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK) &&
+                (dec->main_data.nseg == 1u) &&
+                (dec->main_data.len == (TEST_FRAME_LEN - 4u - 17u));
+
+    bool f1_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK);
+    const uint8_t *main_data_ptr = dec->main_data.seg_ptr[0];
+    f1_b = f1_b && (dec->main_data.nseg == 1u) &&
+           (dec->main_data.len == (TEST_FRAME_LEN - 4u - 17u + 10u)) &&
+           (main_data_ptr[0] == 0xAAu) &&
+           (main_data_ptr[9] == 0xAAu) &&
+           (main_data_ptr[10] == 0xBBu);
+
+    bool end_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) ==
+                  MP3LITE_NEED_MORE_DATA);
+
+    return f0_b && f1_b && end_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing a missing reservoir after flush, and the output buffer size check
+ */
+static bool s_test_decoder_t2(void)
+{
+    static uint8_t stream[2u * TEST_FRAME_LEN];
+    static int16_t pcm[2u * 1152u];
+
+    uint32_t len = s_test_make_frame(stream, 0, 0, 0);
+    len += s_test_make_frame(&stream[len], 0, 100, 0);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    if (!dec)
+    {
+        return false;
+    }
+
+    /* Output buffer too small, the frame is not consumed */
+    (void) mp3lite_decoder_feed(dec, stream, len);
+    bool small_b = (mp3lite_decoder_pull(dec, pcm, 100, NULL) ==
+                    MP3LITE_ERR_INVALID_ARG);
+    bool f0_b = (mp3lite_decoder_pull(dec, pcm, sizeof(pcm), NULL) ==
+                 MP3LITE_OK);
+
+    /* Dropping the second frame, then feeding it again without the first */
+    mp3lite_decoder_flush(dec);
+    bool flush_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) ==
+                    MP3LITE_NEED_MORE_DATA);
+    (void) mp3lite_decoder_feed(dec, &stream[TEST_FRAME_LEN], TEST_FRAME_LEN);
+    bool reservoir_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) ==
+                        MP3LITE_ERR_RESERVOIR);
+
+    mp3lite_decoder_reset(dec);
+    mp3lite_stream_info_t info;
+    bool reset_b = (mp3lite_decoder_stream_info(dec, &info) ==
+                    MP3LITE_NEED_MORE_DATA);
+
+    return small_b && f0_b && flush_b && reservoir_b && reset_b;
+}
+
+
+/*
+ * TEST_3
+ *
+ * Testing the caller-provided memory checks
+ */
+static bool s_test_decoder_t3(void)
+{
+    bool size_b = (mp3lite_decoder_size() <= MP3LITE_DECODER_SIZE) &&
+                  (mp3lite_decoder_size() > INPUT_BUF_SIZE);
+
+    uint8_t *mem = (uint8_t *) s_dec_mem;
+    size_t size = sizeof(s_dec_mem);
+
+    bool null_b = (mp3lite_decoder_init(NULL, size) == NULL);
+    bool small_b = (mp3lite_decoder_init(mem, mp3lite_decoder_size() - 1u) ==
+                    NULL);
+    bool align_b = (mp3lite_decoder_init(&mem[1], size - 1u) == NULL);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(mem,
+                                                  mp3lite_decoder_size());
+    bool init_b = ((void *) dec == (void *) mem);
+
+    return size_b && null_b && small_b && align_b && init_b;
+}
+
+
+/*
+ * TEST_4
+ *
+ * Testing MPEG-2 frames, one granule each, the main data of the third frame
+ * begins in the slot of the first frame
+ */
+static bool s_test_decoder_t4(void)
+{
+    static uint8_t stream[3u * TEST_LSF_FRAME_LEN];
+    const uint32_t slot_len = TEST_LSF_FRAME_LEN - 4u - 17u;
+
+    uint32_t len = s_test_make_lsf_frame(stream, 1, 0, 0xAA);
+    len += s_test_make_lsf_frame(&stream[len], 1, 0, 0xBB);
+    len += s_test_make_lsf_frame(&stream[len], 1, 250, 0xCC);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    mp3lite_stream_info_t info;
+
+    (void) mp3lite_decoder_feed(dec, stream, len);
+    bool feed_b = (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                   MP3LITE_OK) &&
+                  (frame.info.ver == 2u) && (frame.info.nch == 2u) &&
+                  (frame.info.bitrate == 64u) && (frame.info.freq == 22050u) &&
+                  (frame.info.frame_len == TEST_LSF_FRAME_LEN) &&
+                  (frame.info.samples_per_frame == 576u) &&
+                  (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                   MP3LITE_OK) &&
+                  (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                   MP3LITE_OK) &&
+                  (frame.offset == (2u * TEST_LSF_FRAME_LEN)) &&
+                  (dec->main_data.len == (slot_len + 250u)) &&
+                  (dec->main_data.seg_ptr[0][0] == 0xAAu) &&
+                  (dec->main_data.seg_ptr[0][250u - slot_len] == 0xBBu);
+
+    /* In place, from the slots of the three frames */
+    (void) mp3lite_decoder_set_input(dec, stream, len);
+    uint32_t nframes = 0;
+    while (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK)
+    {
+        ++nframes;
+    }
+
+    bool map_b = (nframes == 3u) &&
+                 (frame.offset == (2u * TEST_LSF_FRAME_LEN)) &&
+                 (dec->main_data.nseg == 3u) &&
+                 (dec->main_data.len == (slot_len + 250u)) &&
+                 (mp3lite_decoder_stream_info(dec, &info) == MP3LITE_OK) &&
+                 (info.samples_per_frame == 576u);
+
+    return feed_b && map_b;
+}
+
+
+/*
+ * TEST_5
+ *
+ * Testing one byte slots (MPEG-2, 8 kbits/s, 24000 Hz, two channels, CRC),
+ * the main data of a frame is spread over 256 slots
+ */
+static bool s_test_decoder_t5(void)
+{
+    static uint8_t stream[300u * 24u];
+
+    for (uint32_t i = 0; i < 300u; ++i)
+    {
+        uint8_t *buf = &stream[i * 24u];
+        memset(buf, 0, 24);
+        buf[0] = 0xFF;
+        buf[1] = 0xF2;
+        buf[2] = 0x14;
+        buf[3] = 0x40;
+        buf[6] = (uint8_t) ((i < 255u) ? i : 255u);
+        buf[23] = (uint8_t) i;
+
+        uint16_t crc = s_test_crc16(0xFFFFu, &buf[2], 2);
+        crc = s_test_crc16(crc, &buf[6], 17);
+        buf[4] = (uint8_t) (crc >> 8);
+        buf[5] = (uint8_t) crc;
+    }
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    bool success = true;
+
+    (void) mp3lite_decoder_set_input(dec, stream, sizeof(stream));
+    for (uint32_t i = 0; i < 300u; ++i)
+    {
+        uint32_t len = ((i < 255u) ? i : 255u) + 1u;
+        success = success &&
+                  (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                   MP3LITE_OK) &&
+                  (frame.info.frame_len == 24u) && (frame.crc_error == 0u) &&
+                  (dec->main_data.nseg == len) &&
+                  (dec->main_data.len == len) &&
+                  (dec->main_data.seg_ptr[0][0] == (uint8_t) (i + 1u - len));
+    }
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_decoder_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (!s_test_decoder_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
+    if (!s_test_decoder_t4())
+    {
+        exit_code |= TEST_4_FAILED;
+    }
+
+    if (!s_test_decoder_t5())
+    {
+        exit_code |= TEST_5_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
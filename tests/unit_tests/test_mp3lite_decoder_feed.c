@@ -0,0 +1,155 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define TAG_SIZE        100000u
+#define NUM_FRAMES      5u
+#define TAG_LEN         (ID3V2_HEADER_LEN + TAG_SIZE)
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[TAG_LEN + (NUM_FRAMES * TEST_FRAME_LEN) + ID3V1_LEN];
+static uint32_t s_stream_len;
+
+
+/*
+ * An ID3v2 tag full of false frames (cover art), the frames and an ID3v1 tag
+ */
+static void s_make_stream(void)
+{
+    const uint8_t header[ID3V2_HEADER_LEN] = {
+        'I', 'D', '3', 3, 0, 0,
+        (uint8_t) ((TAG_SIZE >> 21) & 0x7Fu),
+        (uint8_t) ((TAG_SIZE >> 14) & 0x7Fu),
+        (uint8_t) ((TAG_SIZE >> 7) & 0x7Fu),
+        (uint8_t) (TAG_SIZE & 0x7Fu)
+    };
+
+    memcpy(s_stream, header, sizeof(header));
+    for (uint32_t pos = ID3V2_HEADER_LEN; pos < TAG_LEN;
+         pos += TEST_FRAME_LEN)
+    {
+        uint8_t frame[TEST_FRAME_LEN];
+        uint32_t len = ((TAG_LEN - pos) < TEST_FRAME_LEN) ? (TAG_LEN - pos) :
+                                                             TEST_FRAME_LEN;
+        (void) s_test_make_frame(frame, 1, 0, 0);
+        memcpy(&s_stream[pos], frame, len);
+    }
+
+    s_stream_len = TAG_LEN;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        s_stream_len += s_test_make_frame(&s_stream[s_stream_len], 3, 0, 0);
+    }
+
+    memset(&s_stream[s_stream_len], 0xFF, ID3V1_LEN);
+    memcpy(&s_stream[s_stream_len], "TAG", 3);
+    s_stream_len += ID3V1_LEN;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the ID3v2 tag skipped in fed input, in chunks of any size
+ */
+static bool s_test_decoder_feed_t0(void)
+{
+    s_make_stream();
+
+    bool success = true;
+
+    for (uint32_t chunk_len = 1; chunk_len < 5000u; chunk_len *= 7u)
+    {
+        mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                      sizeof(s_dec_mem));
+        mp3lite_frame_t frame;
+        uint32_t pos = 0;
+        uint32_t nframes = 0;
+        int result = MP3LITE_OK;
+
+        while (pos < s_stream_len)
+        {
+            uint32_t len = ((s_stream_len - pos) < chunk_len) ?
+                           (s_stream_len - pos) : chunk_len;
+            pos += (uint32_t) mp3lite_decoder_feed(dec, &s_stream[pos], len);
+
+            while ((result = mp3lite_decoder_pull(dec, NULL, 0, &frame)) !=
+                   MP3LITE_NEED_MORE_DATA)
+            {
+                success = success && (result == MP3LITE_OK) &&
+                          (frame.offset ==
+                           (TAG_LEN + (nframes * TEST_FRAME_LEN))) &&
+                          (frame.info.mode == 3u);
+                ++nframes;
+            }
+        }
+
+        success = success && (nframes == NUM_FRAMES);
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the tags skipped in place, by the scan and by the split
+ */
+static bool s_test_decoder_feed_t1(void)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    mp3lite_scan_t scan;
+    mp3lite_chunk_t chunks[2];
+
+    (void) mp3lite_decoder_set_input(dec, s_stream, s_stream_len);
+    bool success = (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                    MP3LITE_OK) &&
+                   (frame.offset == TAG_LEN) &&
+                   (mp3lite_decoder_seek(dec, 1152u) == MP3LITE_OK) &&
+                   (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                    MP3LITE_OK) &&
+                   (frame.offset == (TAG_LEN + TEST_FRAME_LEN));
+
+    success = success &&
+              (mp3lite_scan(s_stream, s_stream_len, 0, &scan) ==
+               MP3LITE_OK) &&
+              (scan.nframes == NUM_FRAMES) && (scan.junk_len == 0u) &&
+              (scan.tag_len == (TAG_LEN + ID3V1_LEN));
+
+    success = success &&
+              (mp3lite_split(s_stream, s_stream_len, chunks, 2) == 2u) &&
+              (chunks[0].offset == TAG_LEN) &&
+              (chunks[1].end == (s_stream_len - ID3V1_LEN));
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_feed_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_feed_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
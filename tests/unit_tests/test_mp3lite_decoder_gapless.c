@@ -0,0 +1,210 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES  10u
+#define ENC_DELAY   576u
+#define ENC_PADDING 1000u
+
+/* NUM_FRAMES * 1152 - ENC_DELAY - ENC_PADDING */
+#define NUM_SAMPLES 9944u
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[(NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+
+
+/*
+ * An Info frame with a LAME tag and NUM_FRAMES mono frames
+ */
+static uint32_t s_make_stream(void)
+{
+    uint32_t len = s_test_make_info_frame(s_stream, NUM_FRAMES, ENC_DELAY,
+                                          ENC_PADDING);
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 3, 0, (uint8_t) i);
+    }
+
+    return len;
+}
+
+
+/*
+ * Pulling every frame left, the first must be at offset
+ *
+ * \return  Number of frames pulled
+ */
+static uint32_t s_pull_all(mp3lite_decoder_t *dec, const uint64_t offset)
+{
+    mp3lite_frame_t frame;
+    uint32_t n = 0;
+
+    while (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK)
+    {
+        n += ((n > 0u) || (frame.offset == offset)) ? 1u : 0u;
+    }
+
+    return n;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the delay and the padding when decoding in place, the Info frame
+ * is never returned
+ */
+static bool s_test_decoder_gapless_t0(void)
+{
+    const uint32_t len = s_make_stream();
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_gapless_t gapless;
+
+    bool success = (mp3lite_decoder_set_input(dec, s_stream, len) ==
+                    MP3LITE_OK) &&
+                   (mp3lite_decoder_gapless(dec, &gapless) == MP3LITE_OK) &&
+                   (gapless.enc_delay == ENC_DELAY) &&
+                   (gapless.enc_padding == ENC_PADDING) &&
+                   (gapless.skip == (ENC_DELAY + DECODER_DELAY)) &&
+                   (gapless.nsamples == NUM_SAMPLES) &&
+                   (dec->skip_samples == gapless.skip) &&
+                   (dec->samples_left == NUM_SAMPLES);
+
+    /* Every audio frame, then the counts follow each new input */
+    success = success &&
+              (s_pull_all(dec, TEST_FRAME_LEN) == NUM_FRAMES) &&
+              (mp3lite_decoder_set_input(dec, &s_stream[TEST_FRAME_LEN],
+                                         len - TEST_FRAME_LEN) ==
+               MP3LITE_OK) &&
+              (dec->skip_samples == 0u) &&
+              (dec->samples_left == UINT64_MAX) &&
+              (mp3lite_decoder_set_input(dec, s_stream, len) == MP3LITE_OK) &&
+              (dec->skip_samples == gapless.skip) &&
+              (dec->samples_left == NUM_SAMPLES);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing fed input, and a stream without an Info frame
+ */
+static bool s_test_decoder_gapless_t1(void)
+{
+    const uint32_t len = s_make_stream();
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_gapless_t gapless;
+
+    bool success = (mp3lite_decoder_gapless(dec, &gapless) ==
+                    MP3LITE_NEED_MORE_DATA) &&
+                   (mp3lite_decoder_feed(dec, s_stream, len) == len) &&
+                   (s_pull_all(dec, TEST_FRAME_LEN) == NUM_FRAMES) &&
+                   (mp3lite_decoder_gapless(dec, &gapless) == MP3LITE_OK) &&
+                   (gapless.nsamples == NUM_SAMPLES) &&
+                   (dec->skip_samples == gapless.skip) &&
+                   (dec->samples_left == NUM_SAMPLES);
+
+    /* From the first audio frame, nothing is trimmed */
+    mp3lite_decoder_reset(dec);
+    success = success &&
+              (mp3lite_decoder_feed(dec, &s_stream[TEST_FRAME_LEN],
+                                    len - TEST_FRAME_LEN) ==
+               (len - TEST_FRAME_LEN)) &&
+              (s_pull_all(dec, 0) == NUM_FRAMES) &&
+              (mp3lite_decoder_gapless(dec, &gapless) == MP3LITE_OK) &&
+              (gapless.skip == 0u) && (gapless.nsamples == 0u) &&
+              (dec->skip_samples == 0u) && (dec->samples_left == UINT64_MAX);
+
+    success = success &&
+              (mp3lite_decoder_gapless(NULL, &gapless) ==
+               MP3LITE_ERR_INVALID_ARG) &&
+              (mp3lite_decoder_gapless(dec, NULL) == MP3LITE_ERR_INVALID_ARG);
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing seeks and chunks, samples are counted from the end of the delay
+ */
+static bool s_test_decoder_gapless_t2(void)
+{
+    const uint32_t len = s_make_stream();
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    const uint32_t skip = ENC_DELAY + DECODER_DELAY;
+    mp3lite_frame_t frame;
+
+    bool success = (mp3lite_decoder_set_input(dec, s_stream, len) ==
+                    MP3LITE_OK) &&
+                   (mp3lite_decoder_seek(dec, 0) == MP3LITE_OK) &&
+                   (dec->skip_samples == skip) &&
+                   (dec->samples_left == NUM_SAMPLES) &&
+                   (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                    MP3LITE_OK) &&
+                   (frame.offset == TEST_FRAME_LEN);
+
+    /* The last sample is in the last frame */
+    success = success &&
+              (mp3lite_decoder_seek(dec, NUM_SAMPLES - 1u) == MP3LITE_OK) &&
+              (dec->skip_samples == (NUM_SAMPLES - 1u + skip -
+                                     ((NUM_FRAMES - 1u) * 1152u))) &&
+              (dec->samples_left == 1u) &&
+              (mp3lite_decoder_seek(dec, NUM_SAMPLES) ==
+               MP3LITE_ERR_INVALID_ARG);
+
+    /* Only the first chunk is trimmed, the Info frame is in no chunk */
+    mp3lite_chunk_t chunks[2];
+    success = success && (mp3lite_split(s_stream, len, chunks, 2) == 2u) &&
+              (chunks[0].offset == TEST_FRAME_LEN) &&
+              (mp3lite_decoder_set_chunk(dec, s_stream, len, &chunks[0]) ==
+               MP3LITE_OK) &&
+              (dec->skip_samples == skip) &&
+              (dec->samples_left == NUM_SAMPLES) &&
+              (s_pull_all(dec, TEST_FRAME_LEN) == chunks[0].nframes) &&
+              (mp3lite_decoder_set_chunk(dec, s_stream, len, &chunks[1]) ==
+               MP3LITE_OK) &&
+              (dec->skip_samples == 0u) &&
+              (dec->samples_left == UINT64_MAX) &&
+              (s_pull_all(dec, chunks[1].offset) == chunks[1].nframes);
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_gapless_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_gapless_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_decoder_gapless_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,122 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES 20u
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[NUM_FRAMES * TEST_FRAME_LEN];
+
+
+/*
+ * Mono frames, main_data_begin reaches two slots back from the third frame
+ */
+static uint32_t s_make_stream(void)
+{
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 3, (i < 2u) ? 0u : 500u,
+                                 (uint8_t) i);
+    }
+
+    return len;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing seeks into the middle of a frame, with the pre-roll, seeking is
+ * frame accurate
+ */
+static bool s_test_decoder_seek_t0(void)
+{
+    const uint32_t len = s_make_stream();
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    bool success = (mp3lite_decoder_set_input(dec, s_stream, len) ==
+                    MP3LITE_OK);
+
+    /* Frame 5, 1 warm-up frame and 2 frames of main data before it */
+    success = success &&
+              (mp3lite_decoder_seek(dec, (5u * 1152u) + 100u) ==
+               MP3LITE_OK) &&
+              (dec->input_pos == (2u * TEST_FRAME_LEN)) &&
+              (dec->preroll_frames == 3u) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+              (frame.offset == (5u * TEST_FRAME_LEN)) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+              (frame.offset == (6u * TEST_FRAME_LEN));
+
+    /* Backwards, to the first sample of frame 1 */
+    success = success &&
+              (mp3lite_decoder_seek(dec, 1152u) == MP3LITE_OK) &&
+              (dec->input_pos == 0u) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+              (frame.offset == TEST_FRAME_LEN);
+
+    /* The last sample */
+    success = success &&
+              (mp3lite_decoder_seek(dec, (NUM_FRAMES * 1152u) - 1u) ==
+               MP3LITE_OK) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+              (frame.offset == ((NUM_FRAMES - 1u) * TEST_FRAME_LEN)) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+               MP3LITE_NEED_MORE_DATA);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing seeks past the end and when the input is fed
+ */
+static bool s_test_decoder_seek_t1(void)
+{
+    const uint32_t len = s_make_stream();
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+
+    bool fed_b = (mp3lite_decoder_feed(dec, s_stream, TEST_FRAME_LEN) ==
+                  TEST_FRAME_LEN) &&
+                 (mp3lite_decoder_seek(dec, 0) == MP3LITE_ERR_INVALID_ARG);
+
+    bool end_b = (mp3lite_decoder_set_input(dec, s_stream, len) ==
+                  MP3LITE_OK) &&
+                 (mp3lite_decoder_seek(dec, NUM_FRAMES * 1152u) ==
+                  MP3LITE_ERR_INVALID_ARG) &&
+                 (mp3lite_decoder_seek(NULL, 0) == MP3LITE_ERR_INVALID_ARG);
+
+    return fed_b && end_b;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_seek_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_seek_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,228 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES      8u
+#define BAD_CRC_FRAME   2u
+#define OVERRUN_FRAME   5u
+#define GARBAGE_LEN     ((2u * SYNC_SCAN_MAX) + 1000u)
+
+/* Frame with invalid side information in TEST_2, and main_data_begin after */
+#define BAD_SIDE_FRAME  2u
+#define MAIN_DATA_BEGIN 100u
+
+/* Main data slot of an unprotected mono frame */
+#define SLOT_LEN        (TEST_FRAME_LEN - HEADER_LEN - 17u)
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[GARBAGE_LEN + (NUM_FRAMES * TEST_FRAME_LEN)];
+static uint32_t s_stream_len;
+
+
+/*
+ * Protected mono frames, BAD_CRC_FRAME has a private bit flipped and
+ * OVERRUN_FRAME has a part2_3_length of 4095 bits in a 394 bytes slot
+ */
+static void s_make_stream(void)
+{
+    s_stream_len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint8_t *frame = &s_stream[s_stream_len];
+        s_stream_len += s_test_make_protected_frame(frame, 3, 0, 0);
+
+        if (i == OVERRUN_FRAME)
+        {
+            /* Bits 18-29 of the side information */
+            frame[HEADER_LEN + CRC_LEN + 2u] |= 0x3Fu;
+            frame[HEADER_LEN + CRC_LEN + 3u] |= 0xFCu;
+
+            uint16_t crc = s_test_crc16(0xFFFFu, &frame[2], 2);
+            crc = s_test_crc16(crc, &frame[HEADER_LEN + CRC_LEN], 17);
+            frame[HEADER_LEN] = (uint8_t) (crc >> 8);
+            frame[HEADER_LEN + 1u] = (uint8_t) crc;
+        }
+    }
+    s_stream[(BAD_CRC_FRAME * TEST_FRAME_LEN) + HEADER_LEN + CRC_LEN + 1u] ^=
+        0x20u;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing damaged frames without and with concealment
+ */
+static bool s_test_decoder_set_conceal_t0(void)
+{
+    s_make_stream();
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    bool success = (dec->conceal_b == false);
+
+    for (uint8_t conceal = 0; conceal <= 1u; ++conceal)
+    {
+        success = success &&
+                  (mp3lite_decoder_set_conceal(dec, conceal) == MP3LITE_OK) &&
+                  (mp3lite_decoder_set_crc(dec, MP3LITE_CRC_DROP) ==
+                   MP3LITE_OK) &&
+                  (mp3lite_decoder_set_input(dec, s_stream, s_stream_len) ==
+                   MP3LITE_OK);
+
+        for (uint32_t i = 0; success && (i < NUM_FRAMES); ++i)
+        {
+            int expected = (i == BAD_CRC_FRAME) ? MP3LITE_ERR_CRC :
+                           (i == OVERRUN_FRAME) ? MP3LITE_ERR_MAIN_DATA :
+                                                  MP3LITE_OK;
+            expected = (conceal && (expected != MP3LITE_OK)) ?
+                       MP3LITE_CONCEALED : expected;
+            mp3lite_frame_t frame;
+
+            success = (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+                       expected) &&
+                      (frame.offset == (i * TEST_FRAME_LEN)) &&
+                      (dec->nconcealed ==
+                       ((conceal && (expected != MP3LITE_OK)) ? 2u : 0u));
+        }
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the resync: a false sync in the garbage is not taken since no
+ * frame follows it, and a long run of garbage gives control back
+ */
+static bool s_test_decoder_set_conceal_t1(void)
+{
+    memset(s_stream, 0, GARBAGE_LEN);
+    (void) s_test_make_frame(&s_stream[100], 0, 0, 0);
+    s_stream[100u + TEST_FRAME_LEN] = 0xFFu;
+
+    uint32_t len = GARBAGE_LEN;
+    for (uint32_t i = 0; i < 2u; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 1, 0, 0);
+    }
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    (void) mp3lite_decoder_set_input(dec, s_stream, len);
+
+    mp3lite_frame_t frame;
+    int result = mp3lite_decoder_pull(dec, NULL, 0, &frame);
+    bool success = (result == MP3LITE_ERR_SYNC);
+
+    while (result == MP3LITE_ERR_SYNC)
+    {
+        result = mp3lite_decoder_pull(dec, NULL, 0, &frame);
+    }
+
+    return success && (result == MP3LITE_OK) &&
+           (frame.offset == GARBAGE_LEN) &&
+           (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+           (frame.offset == (GARBAGE_LEN + TEST_FRAME_LEN)) &&
+           (mp3lite_decoder_set_conceal(NULL, 1) == MP3LITE_ERR_INVALID_ARG) &&
+           (mp3lite_decoder_set_conceal(dec, 2) == MP3LITE_ERR_INVALID_ARG);
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing a frame with invalid side information (block_type 0 in a window
+ * switching granule), the main data of the next frame begins
+ * MAIN_DATA_BEGIN bytes back in its slot, fed and in place, without and
+ * with concealment
+ */
+static bool s_test_decoder_set_conceal_t2(void)
+{
+    uint32_t len = 0;
+    for (uint32_t i = 0; i <= (BAD_SIDE_FRAME + 1u); ++i)
+    {
+        uint16_t main_data_begin = (i == (BAD_SIDE_FRAME + 1u)) ?
+                                   MAIN_DATA_BEGIN : 0;
+        len += s_test_make_frame(&s_stream[len], 3, main_data_begin,
+                                 (uint8_t) (0x10u + i));
+    }
+
+    /* window_switching_flag of granule 0, bit 51 of the side information */
+    s_stream[(BAD_SIDE_FRAME * TEST_FRAME_LEN) + HEADER_LEN + 6u] |= 0x10u;
+
+    bool success = true;
+
+    for (uint8_t mode = 0; success && (mode < 4u); ++mode)
+    {
+        const bool in_place = (mode & 0x01u);
+        const uint8_t conceal = (mode >> 1);
+
+        mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                      sizeof(s_dec_mem));
+        (void) mp3lite_decoder_set_conceal(dec, conceal);
+
+        if (in_place)
+        {
+            (void) mp3lite_decoder_set_input(dec, s_stream, len);
+        }
+        else
+        {
+            success = (mp3lite_decoder_feed(dec, s_stream, len) == len);
+        }
+
+        for (uint32_t i = 0; success && (i <= (BAD_SIDE_FRAME + 1u)); ++i)
+        {
+            int expected = (i != BAD_SIDE_FRAME) ? MP3LITE_OK :
+                           (conceal) ? MP3LITE_CONCEALED :
+                                       MP3LITE_ERR_SIDE_INFO;
+            success = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == expected);
+        }
+
+        /* The last segment is the own slot of the frame */
+        const main_data_t *main_data = &dec->main_data;
+        const uint32_t last = main_data->nseg - 1u;
+
+        success = success && (main_data->nseg == ((in_place) ? 2u : 1u)) &&
+                  (main_data->len == (MAIN_DATA_BEGIN + SLOT_LEN)) &&
+                  (main_data->seg_ptr[0][0] == (0x10u + BAD_SIDE_FRAME)) &&
+                  (main_data->seg_ptr[last][main_data->seg_len[last] - 1u] ==
+                   (0x11u + BAD_SIDE_FRAME));
+    }
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_set_conceal_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_set_conceal_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_decoder_set_conceal_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,199 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES      6u
+#define BAD_FRAME       2u
+
+/* main_data_begin of the frame after BAD_FRAME in TEST_3 */
+#define MAIN_DATA_BEGIN 100u
+
+/* Main data slot of a protected stereo frame */
+#define SLOT_LEN        (TEST_FRAME_LEN - HEADER_LEN - CRC_LEN - 32u)
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[NUM_FRAMES * TEST_FRAME_LEN];
+
+
+/*
+ * Pulling every frame with a CRC policy, BAD_FRAME has a private bit of its
+ * side information flipped
+ *
+ * \return  true if every frame comes out with the expected result and
+ *          crc_error
+ */
+static bool s_pull_check(const uint8_t policy)
+{
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        len += s_test_make_protected_frame(&s_stream[len], 0, 0, 0);
+    }
+    s_stream[(BAD_FRAME * TEST_FRAME_LEN) + HEADER_LEN + CRC_LEN + 1u] ^=
+        0x20u;
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    bool success = (mp3lite_decoder_set_crc(dec, policy) == MP3LITE_OK) &&
+                   (mp3lite_decoder_set_input(dec, s_stream, len) ==
+                    MP3LITE_OK);
+
+    for (uint32_t i = 0; success && (i < NUM_FRAMES); ++i)
+    {
+        bool bad = (i == BAD_FRAME) && (policy != MP3LITE_CRC_SKIP);
+        int expected = (bad && (policy == MP3LITE_CRC_DROP)) ?
+                       MP3LITE_ERR_CRC : MP3LITE_OK;
+        mp3lite_frame_t frame;
+
+        success = (mp3lite_decoder_pull(dec, NULL, 0, &frame) == expected) &&
+                  (frame.offset == (i * TEST_FRAME_LEN)) &&
+                  (frame.crc_error == ((bad) ? 1u : 0u));
+    }
+
+    return success && (mp3lite_decoder_pull(dec, NULL, 0, NULL) ==
+                       MP3LITE_NEED_MORE_DATA);
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing MP3LITE_CRC_SKIP, the default
+ */
+static bool s_test_decoder_set_crc_t0(void)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+
+    return (dec->crc_policy == MP3LITE_CRC_SKIP) &&
+           s_pull_check(MP3LITE_CRC_SKIP);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing MP3LITE_CRC_VERIFY and MP3LITE_CRC_DROP
+ */
+static bool s_test_decoder_set_crc_t1(void)
+{
+    return s_pull_check(MP3LITE_CRC_VERIFY) &&
+           s_pull_check(MP3LITE_CRC_DROP);
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing invalid arguments and the policy kept by mp3lite_decoder_reset()
+ */
+static bool s_test_decoder_set_crc_t2(void)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    bool success = (mp3lite_decoder_set_crc(NULL, MP3LITE_CRC_SKIP) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_decoder_set_crc(dec, 3) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_decoder_set_crc(dec, MP3LITE_CRC_DROP) ==
+                    MP3LITE_OK);
+
+    mp3lite_decoder_reset(dec);
+
+    return success && (dec->crc_policy == MP3LITE_CRC_DROP);
+}
+
+
+/*
+ * TEST_3
+ *
+ * Testing the main data of the frame after a dropped frame, it begins
+ * MAIN_DATA_BEGIN bytes back in the slot of the dropped frame, fed and in
+ * place
+ */
+static bool s_test_decoder_set_crc_t3(void)
+{
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint16_t main_data_begin = (i == (BAD_FRAME + 1u)) ?
+                                   MAIN_DATA_BEGIN : 0;
+        len += s_test_make_protected_frame(&s_stream[len], 0, main_data_begin,
+                                           (uint8_t) (0x10u + i));
+    }
+    s_stream[(BAD_FRAME * TEST_FRAME_LEN) + HEADER_LEN + CRC_LEN + 1u] ^=
+        0x20u;
+
+    bool success = true;
+
+    for (uint8_t in_place = 0; success && (in_place < 2u); ++in_place)
+    {
+        mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                      sizeof(s_dec_mem));
+        (void) mp3lite_decoder_set_crc(dec, MP3LITE_CRC_DROP);
+
+        if (in_place)
+        {
+            (void) mp3lite_decoder_set_input(dec, s_stream, len);
+        }
+        else
+        {
+            success = (mp3lite_decoder_feed(dec, s_stream, len) == len);
+        }
+
+        for (uint32_t i = 0; success && (i <= (BAD_FRAME + 1u)); ++i)
+        {
+            int expected = (i == BAD_FRAME) ? MP3LITE_ERR_CRC : MP3LITE_OK;
+            success = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == expected);
+        }
+
+        /* The last segment is the own slot of the frame */
+        const main_data_t *main_data = &dec->main_data;
+        const uint32_t last = main_data->nseg - 1u;
+
+        success = success && (main_data->nseg == ((in_place) ? 2u : 1u)) &&
+                  (main_data->len == (MAIN_DATA_BEGIN + SLOT_LEN)) &&
+                  (main_data->seg_ptr[0][0] == (0x10u + BAD_FRAME)) &&
+                  (main_data->seg_ptr[last][main_data->seg_len[last] - 1u] ==
+                   (0x11u + BAD_FRAME));
+    }
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decoder_set_crc_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decoder_set_crc_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_decoder_set_crc_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (!s_test_decoder_set_crc_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
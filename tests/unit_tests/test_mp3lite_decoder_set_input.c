@@ -0,0 +1,162 @@
+#define MP3LITE_USE_MADVISE
+
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+/* Mono frames, the third one refers back to both previous slots */
+#define NUM_FRAMES 4u
+#define SLOT_LEN (TEST_FRAME_LEN - 4u - 17u)
+
+static uint32_t s_make_stream(uint8_t *stream)
+{
+    uint32_t len = 0;
+    len += s_test_make_frame(&stream[len], 3, 0, 0xA0);
+    len += s_test_make_frame(&stream[len], 3, 0, 0xA1);
+    len += s_test_make_frame(&stream[len], 3, 511, 0xA2);
+    len += s_test_make_frame(&stream[len], 3, 20, 0xA3);
+
+    return len;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing in place decoding from a buffer, the main data of the third frame
+ * is split into three segments pointing into the buffer
+ */
+static bool s_test_set_input_t0(void)
+{
+    static uint8_t stream[NUM_FRAMES * TEST_FRAME_LEN];
+    uint32_t len = s_make_stream(stream);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    if (!dec || (mp3lite_decoder_set_input(dec, stream, len) != MP3LITE_OK))
+    {
+        return false;
+    }
+
+    /* Nothing is fed in this mode */
+    bool feed_b = (mp3lite_decoder_feed(dec, stream, 10) == 0u);
+
+    bool f0_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK);
+    bool f1_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK);
+    bool f2_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK);
+
+    const main_data_t *md = &dec->main_data;
+    const uint8_t *slot_0 = &stream[4u + 17u];
+    const uint8_t *slot_1 = &stream[TEST_FRAME_LEN + 4u + 17u];
+    const uint8_t *slot_2 = &stream[2u * TEST_FRAME_LEN + 4u + 17u];
+
+    bool seg_b = (md->nseg == 3u) && (md->len == (511u + SLOT_LEN)) &&
+                 (md->seg_ptr[0] == &slot_0[2u * SLOT_LEN - 511u]) &&
+                 (md->seg_len[0] == (511u - SLOT_LEN)) &&
+                 (md->seg_ptr[1] == slot_1) && (md->seg_len[1] == SLOT_LEN) &&
+                 (md->seg_ptr[2] == slot_2) && (md->seg_len[2] == SLOT_LEN);
+
+    bool f3_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK) &&
+                (md->nseg == 2u) && (md->seg_len[0] == 20u);
+
+    bool end_b = (mp3lite_decoder_pull(dec, NULL, 0, NULL) ==
+                  MP3LITE_NEED_MORE_DATA);
+
+    return feed_b && f0_b && f1_b && f2_b && seg_b && f3_b && end_b;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing in place decoding of a memory mapped file against fed chunks,
+ * the main data must be the same
+ */
+static bool s_test_set_input_t1(void)
+{
+    static uint8_t stream[NUM_FRAMES * TEST_FRAME_LEN];
+    static uint8_t main_data[NUM_FRAMES][MAIN_DATA_BEGIN_MAX + SLOT_LEN];
+    uint32_t main_data_len[NUM_FRAMES];
+    uint32_t len = s_make_stream(stream);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    (void) mp3lite_decoder_feed(dec, stream, len);
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        (void) mp3lite_decoder_pull(dec, NULL, 0, NULL);
+        main_data_len[i] = dec->main_data.len;
+        memcpy(main_data[i], dec->main_data.seg_ptr[0], dec->main_data.len);
+    }
+
+    char path[] = "/tmp/mp3lite_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        return false;
+    }
+    (void) unlink(path);
+    bool write_b = (write(fd, stream, len) == (ssize_t) len);
+
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void) close(fd);
+    if (!write_b || (map == MAP_FAILED))
+    {
+        return false;
+    }
+
+    bool same_b = (mp3lite_decoder_set_input(dec, map, len) == MP3LITE_OK);
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        same_b = same_b &&
+                 (mp3lite_decoder_pull(dec, NULL, 0, NULL) == MP3LITE_OK) &&
+                 (dec->main_data.len == main_data_len[i]);
+
+        uint32_t pos = 0;
+        for (uint32_t j = 0; same_b && (j < dec->main_data.nseg); ++j)
+        {
+            same_b = (memcmp(&main_data[i][pos], dec->main_data.seg_ptr[j],
+                             dec->main_data.seg_len[j]) == 0);
+            pos += dec->main_data.seg_len[j];
+        }
+    }
+
+    /* Back to feeding */
+    bool feed_b = (mp3lite_decoder_set_input(dec, NULL, 0) == MP3LITE_OK) &&
+                  (mp3lite_decoder_feed(dec, stream, 10) == 10u);
+
+    (void) munmap(map, len);
+
+    return same_b && feed_b;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_set_input_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_set_input_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,223 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+/*
+ * Stress test for reentrancy, many decoder contexts run on many threads at the
+ * same time, and their output must match a single-threaded run
+ */
+
+#define NUM_STREAMS     8u
+#define NUM_FRAMES      24u
+#define NUM_THREADS     16u
+#define NUM_CONTEXTS    512u    /* Split evenly between the threads */
+#define NUM_REPEATS     4u      /* Each context decodes its stream again */
+
+#define CONTEXTS_PER_THREAD (NUM_CONTEXTS / NUM_THREADS)
+
+static uint8_t s_streams[NUM_STREAMS][NUM_FRAMES * TEST_FRAME_LEN];
+static uint32_t s_stream_len[NUM_STREAMS];
+static uint64_t s_expected[NUM_STREAMS];
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[NUM_CONTEXTS][MP3LITE_DECODER_SIZE /
+                                        sizeof(uint64_t)];
+
+/* Number of mismatches of each thread, written by that thread only */
+static uint32_t s_mismatch[NUM_THREADS];
+
+
+/* FNV-1a */
+static uint64_t s_hash(uint64_t hash, const uint8_t *data, const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3u;
+    }
+
+    return hash;
+}
+
+
+static void s_make_streams(void)
+{
+    for (uint32_t k = 0; k < NUM_STREAMS; ++k)
+    {
+        uint32_t len = 0;
+        for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+        {
+            uint16_t main_data_begin = (i == 0u) ? 0u :
+                                       (uint16_t) (((i * 37u) + (k * 11u)) %
+                                                   200u);
+            len += s_test_make_frame(&s_streams[k][len], (uint8_t) (k % 4u),
+                                     main_data_begin,
+                                     (uint8_t) ((k * 31u) + i));
+        }
+        s_stream_len[k] = len;
+    }
+}
+
+
+/*
+ * Pulling one frame and adding everything it produced to the hash
+ *
+ * \return  The mp3lite_decoder_pull() result
+ */
+static int s_pull_hash(mp3lite_decoder_t *dec, uint64_t *hash)
+{
+    mp3lite_frame_t frame;
+    int result = mp3lite_decoder_pull(dec, NULL, 0, &frame);
+
+    if (result == MP3LITE_OK)
+    {
+        *hash = s_hash(*hash, (const uint8_t *) &frame.offset,
+                       sizeof(frame.offset));
+        *hash = s_hash(*hash, &frame.info.mode, 1);
+        *hash = s_hash(*hash, (const uint8_t *) &dec->side_info.main_data_begin,
+                       sizeof(dec->side_info.main_data_begin));
+
+        for (uint32_t j = 0; j < dec->main_data.nseg; ++j)
+        {
+            *hash = s_hash(*hash, dec->main_data.seg_ptr[j],
+                           dec->main_data.seg_len[j]);
+        }
+    }
+
+    return result;
+}
+
+
+/*
+ * Decoding a whole stream by feeding chunks of chunk_len bytes
+ */
+static uint64_t s_decode_fed(mp3lite_decoder_t *dec, const uint32_t k,
+                             const uint32_t chunk_len)
+{
+    uint64_t hash = 0xCBF29CE484222325u;
+    uint32_t pos = 0;
+
+    mp3lite_decoder_reset(dec);
+
+    while (pos < s_stream_len[k])
+    {
+        uint32_t len = s_stream_len[k] - pos;
+        len = (len < chunk_len) ? len : chunk_len;
+        pos += (uint32_t) mp3lite_decoder_feed(dec, &s_streams[k][pos], len);
+
+        while (s_pull_hash(dec, &hash) != MP3LITE_NEED_MORE_DATA)
+        {
+        }
+    }
+
+    return hash;
+}
+
+
+/*
+ * Decoding a whole stream in place
+ */
+static uint64_t s_decode_in_place(mp3lite_decoder_t *dec, const uint32_t k)
+{
+    uint64_t hash = 0xCBF29CE484222325u;
+
+    mp3lite_decoder_reset(dec);
+    (void) mp3lite_decoder_set_input(dec, s_streams[k], s_stream_len[k]);
+
+    while (s_pull_hash(dec, &hash) != MP3LITE_NEED_MORE_DATA)
+    {
+    }
+
+    return hash;
+}
+
+
+static void *s_thread(void *arg)
+{
+    const uint32_t t = *(const uint32_t *) arg;
+    mp3lite_decoder_t *decs[CONTEXTS_PER_THREAD];
+
+    for (uint32_t c = 0; c < CONTEXTS_PER_THREAD; ++c)
+    {
+        uint32_t idx = (t * CONTEXTS_PER_THREAD) + c;
+        decs[c] = mp3lite_decoder_init(s_dec_mem[idx], sizeof(s_dec_mem[idx]));
+    }
+
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t c = 0; c < CONTEXTS_PER_THREAD; ++c)
+        {
+            uint32_t idx = (t * CONTEXTS_PER_THREAD) + c;
+            uint32_t k = (idx + r) % NUM_STREAMS;
+            uint64_t hash = ((idx % 2u) == 0u) ?
+                            s_decode_fed(decs[c], k, 1u + ((idx * 7u) % 600u)) :
+                            s_decode_in_place(decs[c], k);
+
+            s_mismatch[t] += (hash == s_expected[k]) ? 0u : 1u;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing NUM_CONTEXTS contexts on NUM_THREADS threads against a single
+ * threaded run
+ */
+static bool s_test_threads_t0(void)
+{
+    s_make_streams();
+
+    /* Single threaded reference with the whole stream fed at once */
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem[0],
+                                                  sizeof(s_dec_mem[0]));
+    for (uint32_t k = 0; k < NUM_STREAMS; ++k)
+    {
+        s_expected[k] = s_decode_fed(dec, k, s_stream_len[k]);
+    }
+
+    pthread_t threads[NUM_THREADS];
+    uint32_t thread_idx[NUM_THREADS];
+    bool create_b = true;
+
+    for (uint32_t t = 0; t < NUM_THREADS; ++t)
+    {
+        thread_idx[t] = t;
+        create_b = create_b &&
+                   (pthread_create(&threads[t], NULL, s_thread,
+                                   &thread_idx[t]) == 0);
+    }
+
+    uint32_t mismatch = 0;
+    for (uint32_t t = 0; t < NUM_THREADS; ++t)
+    {
+        (void) pthread_join(threads[t], NULL);
+        mismatch += s_mismatch[t];
+    }
+
+    return create_b && (mismatch == 0u);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_threads_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
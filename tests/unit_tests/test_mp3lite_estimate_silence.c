@@ -0,0 +1,260 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES  12u
+#define SPF         1152u
+
+static uint8_t s_stream[(NUM_FRAMES + 1u) * TEST_FRAME_LEN];
+
+
+/*
+ * Writing value in len bits at bit pos of the side information, MSB first
+ */
+static void s_write_bits(uint8_t *frame,
+                         const uint32_t pos,
+                         const uint32_t len,
+                         const uint32_t value)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        uint32_t bit = pos + i;
+        uint8_t mask = (uint8_t) (0x80u >> (bit % 8u));
+        uint8_t *byte = &frame[HEADER_LEN + (bit / 8u)];
+
+        *byte = (((value >> (len - 1u - i)) & 0x01u) != 0u) ?
+                (uint8_t) (*byte | mask) : (uint8_t) (*byte & ~mask);
+    }
+}
+
+
+/*
+ * Mono frame, both granules with the same part2_3_length, big_values,
+ * global_gain and table_select[0..2] (table 15)
+ */
+static void s_make_granules(uint8_t *frame,
+                            const uint32_t part2_3_length,
+                            const uint32_t big_values,
+                            const uint32_t global_gain)
+{
+    (void) s_test_make_frame(frame, 3, 0, 0);
+
+    for (uint32_t gr = 0; gr < 2u; ++gr)
+    {
+        /* 18 bits before the granules, 59 bits a granule */
+        const uint32_t pos = 18u + (gr * 59u);
+        s_write_bits(frame, pos, 12, part2_3_length);
+        s_write_bits(frame, pos + 12u, 9, big_values);
+        s_write_bits(frame, pos + 21u, 8, global_gain);
+        s_write_bits(frame, pos + 34u, 5, 15);
+        s_write_bits(frame, pos + 39u, 5, 15);
+        s_write_bits(frame, pos + 44u, 5, 15);
+    }
+}
+
+
+/*
+ * Frames 0-1: no Huffman data, 2: count1 only at a low global_gain
+ * Frames 3-4, 9: active
+ * Frames 5-7, 10-11: no Huffman data
+ * Frame 8: low-activity, count1 only at a high global_gain with few bits
+ *
+ * \return  Stream length in bytes
+ */
+static uint32_t s_make_stream(uint8_t *buf)
+{
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint8_t *frame = &buf[i * TEST_FRAME_LEN];
+
+        if (i == 2u)
+        {
+            s_make_granules(frame, 60, 0, 150);
+        }
+        else if ((i == 3u) || (i == 4u) || (i == 9u))
+        {
+            s_make_granules(frame, 1000, 100, 200);
+        }
+        else if (i == 8u)
+        {
+            s_make_granules(frame, 50, 0, 200);
+        }
+        else
+        {
+            (void) s_test_make_frame(frame, 3, 0, 0);
+        }
+    }
+
+    return NUM_FRAMES * TEST_FRAME_LEN;
+}
+
+
+static bool s_segment_eq(const mp3lite_segment_t *segment,
+                         const uint64_t start,
+                         const uint64_t len)
+{
+    return (segment->start == start) && (segment->len == len);
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the classification, the segments and the trim points
+ */
+static bool s_test_estimate_silence_t0(void)
+{
+    uint32_t len = s_make_stream(s_stream);
+    mp3lite_silence_cfg_t cfg = {.threshold = -60.0, .low_bits = 100,
+                                 .min_len = 2000, .flags = 0};
+    mp3lite_segment_t segments[4];
+    mp3lite_silence_t silence;
+
+    bool success = (mp3lite_estimate_silence(s_stream, len, &cfg, segments, 4,
+                                             &silence) == MP3LITE_OK) &&
+                   (silence.nframes == NUM_FRAMES) &&
+                   (silence.nsilent == 8u) && (silence.nlow == 1u) &&
+                   (silence.nsamples == (NUM_FRAMES * SPF)) &&
+                   (silence.trim_start == (3u * SPF)) &&
+                   (silence.trim_end == (10u * SPF)) &&
+                   (silence.nsegments == 3u) &&
+                   s_segment_eq(&segments[0], 0, 3u * SPF) &&
+                   s_segment_eq(&segments[1], 5u * SPF, 3u * SPF) &&
+                   s_segment_eq(&segments[2], 10u * SPF, 2u * SPF);
+
+    /* The low-activity frame joins the segment before it */
+    cfg.flags = MP3LITE_SILENCE_LOW;
+    cfg.min_len = 4000;
+    success = success &&
+              (mp3lite_estimate_silence(s_stream, len, &cfg, segments, 4,
+                                        &silence) == MP3LITE_OK) &&
+              (silence.nsilent == 8u) && (silence.nlow == 1u) &&
+              (silence.trim_start == (3u * SPF)) &&
+              (silence.trim_end == (10u * SPF)) &&
+              (silence.nsegments == 1u) &&
+              s_segment_eq(&segments[0], 5u * SPF, 4u * SPF);
+
+    /* A higher threshold takes frame 2 out, segments are counted past */
+    /* max_segments                                                    */
+    cfg.threshold = -100.0;
+    cfg.min_len = 0;
+    success = success &&
+              (mp3lite_estimate_silence(s_stream, len, &cfg, segments, 1,
+                                        &silence) == MP3LITE_OK) &&
+              (silence.nsilent == 7u) && (silence.nlow == 2u) &&
+              (silence.nsegments == 3u) &&
+              s_segment_eq(&segments[0], 0, 3u * SPF);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing samples counted after the delay of a LAME tag, and a silent
+ * stream
+ */
+static bool s_test_estimate_silence_t1(void)
+{
+    /* skip = 47 + 529 = SPF / 2, nsamples = 11 * SPF */
+    uint32_t len = s_test_make_info_frame(s_stream, NUM_FRAMES, 47, 1105);
+    len += s_make_stream(&s_stream[len]);
+
+    mp3lite_silence_cfg_t cfg = {.threshold = -60.0, .low_bits = 100,
+                                 .min_len = 0, .flags = 0};
+    mp3lite_segment_t segments[8];
+    mp3lite_silence_t silence;
+
+    bool success = (mp3lite_estimate_silence(s_stream, len, &cfg, segments, 8,
+                                             &silence) == MP3LITE_OK) &&
+                   (silence.nframes == NUM_FRAMES) &&
+                   (silence.nsamples == (11u * SPF)) &&
+                   (silence.trim_start == ((3u * SPF) - (SPF / 2u))) &&
+                   (silence.trim_end == ((10u * SPF) - (SPF / 2u))) &&
+                   (silence.nsegments == 3u) &&
+                   s_segment_eq(&segments[0], 0, (3u * SPF) - (SPF / 2u)) &&
+                   s_segment_eq(&segments[2], (10u * SPF) - (SPF / 2u),
+                                SPF + (SPF / 2u));
+
+    len = 0;
+    for (uint32_t i = 0; i < 3u; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 1, 0, 0);
+    }
+
+    success = success &&
+              (mp3lite_estimate_silence(s_stream, len, &cfg, segments, 8,
+                                        &silence) == MP3LITE_OK) &&
+              (silence.nsilent == 3u) && (silence.trim_start == 0u) &&
+              (silence.trim_end == 0u) && (silence.nsegments == 1u) &&
+              s_segment_eq(&segments[0], 0, 3u * SPF);
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing invalid arguments
+ */
+static bool s_test_estimate_silence_t2(void)
+{
+    mp3lite_silence_cfg_t cfg = {.threshold = -60.0, .low_bits = 100,
+                                 .min_len = 0, .flags = 0};
+    mp3lite_segment_t segments[1];
+    mp3lite_silence_t silence;
+    bool success = (mp3lite_estimate_silence(NULL, 1, &cfg, segments, 1,
+                                             &silence) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_estimate_silence(s_stream, 1, NULL, segments, 1,
+                                             &silence) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_estimate_silence(s_stream, 1, &cfg, NULL, 1,
+                                             &silence) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_estimate_silence(s_stream, 1, &cfg, segments, 1,
+                                             NULL) ==
+                    MP3LITE_ERR_INVALID_ARG) &&
+                   (mp3lite_estimate_silence(s_stream, 1, &cfg, NULL, 0,
+                                             &silence) == MP3LITE_OK) &&
+                   (silence.nframes == 0u);
+
+    cfg.flags = 2;
+    success = success &&
+              (mp3lite_estimate_silence(s_stream, 1, &cfg, segments, 1,
+                                        &silence) == MP3LITE_ERR_INVALID_ARG);
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_estimate_silence_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_estimate_silence_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_estimate_silence_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
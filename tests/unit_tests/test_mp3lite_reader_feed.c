@@ -0,0 +1,237 @@
+#define MP3LITE_USE_IO_URING
+
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NUM_FRAMES  50u
+#define JUNK_LEN    123u
+#define BLOCK_LEN   1000u
+#define NUM_BLOCKS  4u
+
+/* Caller-provided decoder and reader memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+static uint64_t s_reader_mem[(sizeof(mp3lite_reader_t) +
+                              (NUM_BLOCKS * BLOCK_LEN) + 128u) /
+                             sizeof(uint64_t)];
+
+static uint8_t s_stream[JUNK_LEN + (NUM_FRAMES * TEST_FRAME_LEN)];
+static uint32_t s_stream_len;
+
+/* Result and offset of each frame, decoding the stream in place */
+static int s_expected_result[NUM_FRAMES];
+static uint64_t s_expected_offset[NUM_FRAMES];
+
+
+/*
+ * Writing the stream to a temporary file and decoding it in place
+ *
+ * \return  File descriptor of the file, -1 on failure
+ */
+static int s_make_file(void)
+{
+    memset(s_stream, 0, JUNK_LEN);
+    s_stream_len = JUNK_LEN;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint16_t main_data_begin = (uint16_t) ((i * 137u) % 512u);
+        s_stream_len += s_test_make_frame(&s_stream[s_stream_len],
+                                          (uint8_t) (i % 4u), main_data_begin,
+                                          (uint8_t) i);
+    }
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    int result = MP3LITE_OK;
+    uint32_t n = 0;
+
+    (void) mp3lite_decoder_set_input(dec, s_stream, s_stream_len);
+    while (((result = mp3lite_decoder_pull(dec, NULL, 0, &frame)) !=
+            MP3LITE_NEED_MORE_DATA) && (n < NUM_FRAMES))
+    {
+        s_expected_result[n] = result;
+        s_expected_offset[n] = frame.offset;
+        ++n;
+    }
+
+    char path[] = "/tmp/mp3lite_reader_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        (void) unlink(path);
+        if (write(fd, s_stream, s_stream_len) != (ssize_t) s_stream_len)
+        {
+            (void) close(fd);
+            fd = -1;
+        }
+    }
+
+    return fd;
+}
+
+
+/*
+ * Decoding through the reader and comparing with decoding in place
+ */
+static bool s_decode_check(mp3lite_reader_t *reader, const uint64_t offset)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    mp3lite_frame_t frame;
+    uint32_t n = 0;
+    bool success = (reader != NULL);
+
+    while (success)
+    {
+        int result = mp3lite_decoder_pull(dec, NULL, 0, &frame);
+
+        if (result == MP3LITE_NEED_MORE_DATA)
+        {
+            result = mp3lite_reader_feed(reader, dec);
+            success = (result == MP3LITE_OK) ||
+                      (result == MP3LITE_END_OF_STREAM);
+            if (result == MP3LITE_END_OF_STREAM)
+            {
+                break;
+            }
+        }
+        else
+        {
+            success = (n < NUM_FRAMES) &&
+                      (result == s_expected_result[n]) &&
+                      ((frame.offset + offset) == s_expected_offset[n]);
+            ++n;
+        }
+    }
+
+    mp3lite_reader_close(reader);
+
+    return success && (n == NUM_FRAMES);
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the io_uring reader (pread if io_uring is not available), blocks
+ * and frames are not aligned
+ */
+static bool s_test_reader_feed_t0(void)
+{
+    int fd = s_make_file();
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    mp3lite_reader_t *reader = mp3lite_reader_init(s_reader_mem,
+                                                   sizeof(s_reader_mem),
+                                                   fd, 0, BLOCK_LEN,
+                                                   NUM_BLOCKS);
+    bool success = (mp3lite_reader_size(BLOCK_LEN, NUM_BLOCKS) <=
+                    sizeof(s_reader_mem)) &&
+                   s_decode_check(reader, 0);
+
+    (void) close(fd);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the pread reader, starting after the junk
+ */
+static bool s_test_reader_feed_t1(void)
+{
+    int fd = s_make_file();
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    mp3lite_reader_t *reader = s_reader_init(s_reader_mem,
+                                             sizeof(s_reader_mem), fd,
+                                             JUNK_LEN, BLOCK_LEN, NUM_BLOCKS,
+                                             false);
+    bool success = s_decode_check(reader, JUNK_LEN);
+
+    (void) close(fd);
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing a read error and invalid arguments
+ */
+static bool s_test_reader_feed_t2(void)
+{
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem,
+                                                  sizeof(s_dec_mem));
+    bool success = true;
+
+    /* Reading a directory fails with EISDIR */
+    int fd = open("/", O_RDONLY);
+    for (uint32_t uring = 0; (fd >= 0) && (uring < 2u); ++uring)
+    {
+        mp3lite_reader_t *reader = s_reader_init(s_reader_mem,
+                                                 sizeof(s_reader_mem), fd, 0,
+                                                 BLOCK_LEN, NUM_BLOCKS,
+                                                 (uring == 1u));
+        errno = 0;
+        success = success && reader &&
+                  (mp3lite_reader_feed(reader, dec) == MP3LITE_ERR_IO) &&
+                  (errno == EISDIR);
+        mp3lite_reader_close(reader);
+    }
+    (void) close(fd);
+
+    success = success &&
+              (mp3lite_reader_init(s_reader_mem, sizeof(s_reader_mem), -1, 0,
+                                   BLOCK_LEN, NUM_BLOCKS) == NULL) &&
+              (mp3lite_reader_init(s_reader_mem, sizeof(s_reader_mem), 0, 0,
+                                   BLOCK_LEN, 1) == NULL) &&
+              (mp3lite_reader_init(s_reader_mem, sizeof(s_reader_mem), 0, 0,
+                                   BLOCK_LEN * 2u, NUM_BLOCKS) == NULL) &&
+              (mp3lite_reader_feed(NULL, dec) == MP3LITE_ERR_INVALID_ARG);
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_reader_feed_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_reader_feed_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_reader_feed_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
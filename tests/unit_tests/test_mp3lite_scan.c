@@ -0,0 +1,184 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+/* 160 kbits/s, 44100 Hz, no padding */
+#define FRAME_160_LEN 522u
+
+/* 7 bytes of junk, 3 frames, 2 frames, 100 bytes of a truncated frame */
+#define STREAM_LEN (7u + (3u * TEST_FRAME_LEN) + (2u * FRAME_160_LEN) + 100u)
+
+static uint8_t s_stream[STREAM_LEN];
+
+/* Frames after the Info frame of TEST_2 */
+#define NUM_GAPLESS_FRAMES 10u
+
+static uint8_t s_gapless[(NUM_GAPLESS_FRAMES + 1u) * TEST_FRAME_LEN];
+
+
+/*
+ * Mono 128 kbits/s frames, the first one with a mixed short block in
+ * granule 0, then joint stereo (ms) 160 kbits/s frames
+ */
+static void s_make_stream(void)
+{
+    uint32_t len = 7;
+    memset(s_stream, 0, len);
+
+    for (uint32_t i = 0; i < 3u; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 3, 0, 0);
+    }
+
+    /* window_switching_flag, block_type 2, mixed_block_flag (bits 51-54) */
+    s_stream[7u + 4u + 6u] = 0x1Au;
+
+    uint8_t frame[FRAME_160_LEN];
+    (void) s_test_make_frame(frame, 1, 0, 0);
+    memset(&frame[TEST_FRAME_LEN], 0, FRAME_160_LEN - TEST_FRAME_LEN);
+    frame[2] = 0xA0u;
+    frame[3] |= 0x20u;
+
+    for (uint32_t i = 0; i < 3u; ++i)
+    {
+        uint32_t frame_len = (i < 2u) ? FRAME_160_LEN : 100u;
+        memcpy(&s_stream[len], frame, frame_len);
+        len += frame_len;
+    }
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the header statistics and the junk
+ */
+static bool s_test_scan_t0(void)
+{
+    s_make_stream();
+
+    mp3lite_scan_t scan;
+    if (mp3lite_scan(s_stream, STREAM_LEN, 0, &scan) != MP3LITE_OK)
+    {
+        return false;
+    }
+
+    bool header_b = (scan.nframes == 5u) &&
+                    (scan.nsamples == (5u * 1152u)) &&
+                    (scan.freq == 44100u) &&
+                    (scan.bitrate_min == 128u) &&
+                    (scan.bitrate_max == 160u) &&
+                    (scan.bitrate_avg == 141u) &&
+                    (scan.vbr == 1u) &&
+                    (scan.bitrate_hist[9] == 3u) &&
+                    (scan.bitrate_hist[10] == 2u) &&
+                    (scan.mode[3] == 3u) && (scan.mode[1] == 2u) &&
+                    (scan.mode_ext[2] == 2u) && (scan.mode_ext[0] == 0u) &&
+                    (scan.junk_len == 107u);
+
+    /* The side information is not read */
+    bool side_info_b = (scan.block_type[0] == 0u) &&
+                       (scan.block_type[2] == 0u) &&
+                       (scan.mixed_block == 0u);
+
+    return header_b && side_info_b;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the block type mix and a CBR stream
+ */
+static bool s_test_scan_t1(void)
+{
+    s_make_stream();
+
+    mp3lite_scan_t scan;
+    bool block_b = (mp3lite_scan(s_stream, STREAM_LEN, MP3LITE_SCAN_SIDE_INFO,
+                                 &scan) == MP3LITE_OK) &&
+                   (scan.nframes == 5u) &&
+                   (scan.block_type[0] == 13u) &&
+                   (scan.block_type[2] == 1u) &&
+                   (scan.mixed_block == 1u) &&
+                   (scan.side_info_err == 0u);
+
+    /* The mono frames only */
+    bool cbr_b = (mp3lite_scan(&s_stream[7], 3u * TEST_FRAME_LEN, 0,
+                               &scan) == MP3LITE_OK) &&
+                 (scan.vbr == 0u) && (scan.bitrate_avg == 128u) &&
+                 (scan.junk_len == 0u);
+
+    bool arg_b = (mp3lite_scan(NULL, 0, 0, &scan) ==
+                  MP3LITE_ERR_INVALID_ARG) &&
+                 (mp3lite_scan(s_stream, 0, 0, &scan) == MP3LITE_OK) &&
+                 (scan.nframes == 0u) && (scan.bitrate_avg == 0u);
+
+    return block_b && cbr_b && arg_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing a stream with a LAME tag, the Info frame is not counted
+ */
+static bool s_test_scan_t2(void)
+{
+    uint32_t len = s_test_make_info_frame(s_gapless, NUM_GAPLESS_FRAMES, 576,
+                                          1000);
+    for (uint32_t i = 0; i < NUM_GAPLESS_FRAMES; ++i)
+    {
+        len += s_test_make_frame(&s_gapless[len], 3, 0, 0);
+    }
+
+    mp3lite_scan_t scan;
+
+    /* 10 * 1152 - 576 - 1000 */
+    bool gapless_b = (mp3lite_scan(s_gapless, len, 0, &scan) ==
+                      MP3LITE_OK) &&
+                     (scan.nframes == NUM_GAPLESS_FRAMES) &&
+                     (scan.nsamples == 9944u) &&
+                     (scan.mode[3] == NUM_GAPLESS_FRAMES) &&
+                     (scan.bitrate_avg == 128u) &&
+                     (scan.tag_len == TEST_FRAME_LEN) &&
+                     (scan.junk_len == 0u);
+
+    /* Truncated, the LAME tag counts more samples than the frames hold */
+    bool truncated_b = (mp3lite_scan(s_gapless, 3u * TEST_FRAME_LEN, 0,
+                                     &scan) == MP3LITE_OK) &&
+                       (scan.nframes == 2u) &&
+                       (scan.nsamples == (2u * 1152u));
+
+    return gapless_b && truncated_b;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_scan_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_scan_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_scan_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,343 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define NUM_FRAMES      60u
+#define NUM_CHUNKS      6u
+#define GARBAGE_LEN     5u
+
+/* Caller-provided decoder memory, uint64_t for the alignment */
+static uint64_t s_dec_mem[NUM_CHUNKS][MP3LITE_DECODER_SIZE / sizeof(uint64_t)];
+
+static uint8_t s_stream[NUM_FRAMES * (TEST_FRAME_LEN + GARBAGE_LEN)];
+static uint32_t s_stream_len;
+static mp3lite_chunk_t s_chunks[NUM_CHUNKS];
+
+/* Result and hash of each frame, from one run and the chunked runs */
+static int s_expected_result[NUM_FRAMES];
+static uint64_t s_expected_hash[NUM_FRAMES];
+static int s_chunk_result[NUM_FRAMES];
+static uint64_t s_chunk_hash[NUM_FRAMES];
+
+/* Number of frames pulled from each chunk */
+static uint32_t s_chunk_nframes[NUM_CHUNKS];
+
+
+/* FNV-1a */
+static uint64_t s_hash(uint64_t hash, const uint8_t *data, const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3u;
+    }
+
+    return hash;
+}
+
+
+/*
+ * Pulling every frame left and storing the results from results[0]
+ *
+ * \return  Number of frames pulled
+ */
+static uint32_t s_pull_all(mp3lite_decoder_t *dec,
+                           int *results,
+                           uint64_t *hashes,
+                           const uint32_t max_frames)
+{
+    mp3lite_frame_t frame;
+    uint32_t n = 0;
+    int result = MP3LITE_OK;
+
+    while ((result = mp3lite_decoder_pull(dec, NULL, 0, &frame)) !=
+           MP3LITE_NEED_MORE_DATA)
+    {
+        if (n < max_frames)
+        {
+            uint64_t hash = s_hash(0xCBF29CE484222325u,
+                                   (const uint8_t *) &frame.offset,
+                                   sizeof(frame.offset));
+            for (uint32_t j = 0; (result == MP3LITE_OK) &&
+                                 (j < dec->main_data.nseg); ++j)
+            {
+                hash = s_hash(hash, dec->main_data.seg_ptr[j],
+                              dec->main_data.seg_len[j]);
+            }
+
+            results[n] = result;
+            hashes[n] = hash;
+        }
+        ++n;
+    }
+
+    return n;
+}
+
+
+static void *s_thread(void *arg)
+{
+    const uint32_t k = *(const uint32_t *) arg;
+
+    /* Frame index of the first frame of the chunk */
+    uint32_t first = 0;
+    for (uint32_t j = 0; j < k; ++j)
+    {
+        first += s_chunks[j].nframes;
+    }
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem[k],
+                                                  sizeof(s_dec_mem[k]));
+    if (dec && (mp3lite_decoder_set_chunk(dec, s_stream, s_stream_len,
+                                          &s_chunks[k]) == MP3LITE_OK))
+    {
+        s_chunk_nframes[k] = s_pull_all(dec, &s_chunk_result[first],
+                                        &s_chunk_hash[first],
+                                        NUM_FRAMES - first);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the chunk boundaries and the pre-roll of evenly sized frames
+ */
+static bool s_test_split_t0(void)
+{
+    static uint8_t stream[12u * TEST_FRAME_LEN];
+    mp3lite_chunk_t chunks[4];
+    bool success = true;
+
+    /* main_data_begin: 0 (warm-up only), 500 (two slots back) */
+    for (uint16_t main_data_begin = 0; main_data_begin <= 500u;
+         main_data_begin = (uint16_t) (main_data_begin + 500u))
+    {
+        uint32_t len = 0;
+        for (uint32_t i = 0; i < 12u; ++i)
+        {
+            len += s_test_make_frame(&stream[len], 3,
+                                     (i == 0u) ? 0u : main_data_begin, 0);
+        }
+
+        uint32_t preroll = (main_data_begin == 0u) ? 1u : 3u;
+        uint32_t nchunks = mp3lite_split(stream, len, chunks, 4);
+        success = success && (nchunks == 4u);
+
+        for (uint32_t k = 0; success && (k < nchunks); ++k)
+        {
+            size_t offset = k * 3u * TEST_FRAME_LEN;
+            uint32_t k_preroll = (k == 0u) ? 0u : preroll;
+
+            success = (chunks[k].offset == offset) &&
+                      (chunks[k].end == (offset + (3u * TEST_FRAME_LEN))) &&
+                      (chunks[k].nframes == 3u) &&
+                      (chunks[k].preroll_frames == k_preroll) &&
+                      (chunks[k].preroll_offset ==
+                       (offset - (k_preroll * TEST_FRAME_LEN)));
+        }
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing chunks decoded on one thread each against a single run, the frames
+ * of the chunks must join into the frames of the single run
+ */
+static bool s_test_split_t1(void)
+{
+    /* Joint stereo, garbage between frames, a truncated frame at the end */
+    s_stream_len = 0;
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        uint16_t main_data_begin = (uint16_t) ((i * 137u) % 512u);
+        s_stream_len += s_test_make_frame(&s_stream[s_stream_len], 1,
+                                          main_data_begin, (uint8_t) i);
+
+        if ((i % 7u) == 3u)
+        {
+            memset(&s_stream[s_stream_len], 0, GARBAGE_LEN);
+            s_stream_len += GARBAGE_LEN;
+        }
+    }
+    s_stream_len -= TEST_FRAME_LEN / 2u;
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem[0],
+                                                  sizeof(s_dec_mem[0]));
+    (void) mp3lite_decoder_set_input(dec, s_stream, s_stream_len);
+    uint32_t nframes = s_pull_all(dec, s_expected_result, s_expected_hash,
+                                  NUM_FRAMES);
+
+    uint32_t nchunks = mp3lite_split(s_stream, s_stream_len, s_chunks,
+                                     NUM_CHUNKS);
+    if ((nframes != (NUM_FRAMES - 1u)) || (nchunks != NUM_CHUNKS))
+    {
+        return false;
+    }
+
+    pthread_t threads[NUM_CHUNKS];
+    uint32_t thread_idx[NUM_CHUNKS];
+    bool create_b = true;
+
+    for (uint32_t k = 0; k < NUM_CHUNKS; ++k)
+    {
+        thread_idx[k] = k;
+        create_b = create_b &&
+                   (pthread_create(&threads[k], NULL, s_thread,
+                                   &thread_idx[k]) == 0);
+    }
+
+    bool nframes_b = true;
+    for (uint32_t k = 0; k < NUM_CHUNKS; ++k)
+    {
+        (void) pthread_join(threads[k], NULL);
+        nframes_b = nframes_b && (s_chunk_nframes[k] == s_chunks[k].nframes) &&
+                    (s_chunks[k].nframes > 0u);
+    }
+
+    bool frames_b = true;
+    for (uint32_t i = 0; i < nframes; ++i)
+    {
+        frames_b = frames_b &&
+                   (s_chunk_result[i] == s_expected_result[i]) &&
+                   (s_chunk_hash[i] == s_expected_hash[i]) &&
+                   (s_expected_result[i] == MP3LITE_OK);
+    }
+
+    return create_b && nframes_b && frames_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing fewer frames than chunks and invalid arguments
+ */
+static bool s_test_split_t2(void)
+{
+    uint8_t stream[3u * TEST_FRAME_LEN];
+    mp3lite_chunk_t chunks[8];
+
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < 3u; ++i)
+    {
+        len += s_test_make_frame(&stream[len], 0, 0, 0);
+    }
+
+    bool success = (mp3lite_split(stream, len, chunks, 8) == 3u) &&
+                   (chunks[2].nframes == 1u) && (chunks[2].end == len) &&
+                   (mp3lite_split(stream, TEST_FRAME_LEN - 1u, chunks, 8) ==
+                    0u) &&
+                   (mp3lite_split(NULL, len, chunks, 8) == 0u) &&
+                   (mp3lite_split(stream, len, chunks, 0) == 0u);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem[0],
+                                                  sizeof(s_dec_mem[0]));
+    mp3lite_chunk_t chunk = chunks[2];
+    chunk.end = len + 1u;
+
+    success = success &&
+              (mp3lite_decoder_set_chunk(dec, stream, len, &chunk) ==
+               MP3LITE_ERR_INVALID_ARG) &&
+              (mp3lite_decoder_set_chunk(dec, stream, len, &chunks[2]) ==
+               MP3LITE_OK);
+
+    /* Only the frame of the chunk comes out */
+    mp3lite_frame_t frame;
+    success = success &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) == MP3LITE_OK) &&
+              (frame.offset == (2u * TEST_FRAME_LEN)) &&
+              (mp3lite_decoder_pull(dec, NULL, 0, &frame) ==
+               MP3LITE_NEED_MORE_DATA);
+
+    return success;
+}
+
+
+/*
+ * TEST_3
+ *
+ * Testing a stream with an Info frame, it is in no chunk and the frames of
+ * the chunks start at the first audio frame
+ */
+static bool s_test_split_t3(void)
+{
+    const uint32_t nframes = 40;
+    uint32_t len = s_test_make_info_frame(s_stream, nframes, 576, 1000);
+    for (uint32_t i = 0; i < nframes; ++i)
+    {
+        len += s_test_make_frame(&s_stream[len], 3, 0, (uint8_t) i);
+    }
+
+    mp3lite_chunk_t chunks[4];
+    bool success = (mp3lite_split(s_stream, len, chunks, 4) == 4u) &&
+                   (chunks[0].preroll_offset == TEST_FRAME_LEN) &&
+                   (chunks[0].offset == TEST_FRAME_LEN) &&
+                   (chunks[0].preroll_frames == 0u);
+
+    mp3lite_decoder_t *dec = mp3lite_decoder_init(s_dec_mem[0],
+                                                  sizeof(s_dec_mem[0]));
+    uint32_t idx = 0;
+
+    for (uint32_t k = 0; success && (k < 4u); ++k)
+    {
+        success = (chunks[k].nframes == 10u) &&
+                  (mp3lite_decoder_set_chunk(dec, s_stream, len,
+                                             &chunks[k]) == MP3LITE_OK) &&
+                  (dec->skip_samples == ((k == 0u) ? (576u + 529u) : 0u));
+
+        /* Frame idx of the job is frame idx + 1 of the stream */
+        mp3lite_frame_t frame;
+        while (success &&
+               (mp3lite_decoder_pull(dec, NULL, 0, &frame) !=
+                MP3LITE_NEED_MORE_DATA))
+        {
+            ++idx;
+            success = (frame.offset == ((uint64_t) idx * TEST_FRAME_LEN));
+        }
+    }
+
+    return success && (idx == nframes);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_split_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_split_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_split_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (!s_test_split_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
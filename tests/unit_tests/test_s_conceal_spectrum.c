@@ -0,0 +1,60 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+
+#include <stdio.h>
+
+#define XR_LEN  (NCH_MAX * GRANULE_LEN)
+
+#define EPSILON 1e-6f
+
+
+/*
+ * TEST_0
+ *
+ * Testing the repeated spectrum, the fade out and the muting
+ */
+static bool s_test_conceal_spectrum_t0(void)
+{
+    static float xr[XR_LEN];
+    bool success = true;
+
+    for (uint32_t i = 0; i < XR_LEN; ++i)
+    {
+        xr[i] = (float) ((int32_t) (i % 17u) - 8);
+    }
+
+    float gain = 1.0f;
+    for (uint32_t n = 1; n <= (CONCEAL_GRANULES_MAX + 1u); ++n)
+    {
+        s_conceal_spectrum(xr, XR_LEN, n);
+
+        gain *= (n > 1u) ? CONCEAL_GAIN : 1.0f;
+        gain = (n > CONCEAL_GRANULES_MAX) ? 0.0f : gain;
+
+        for (uint32_t i = 0; i < XR_LEN; ++i)
+        {
+            float diff = xr[i] - ((float) ((int32_t) (i % 17u) - 8) * gain);
+            success = success && (diff < EPSILON) && (diff > -EPSILON);
+        }
+    }
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_conceal_spectrum_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,166 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+
+#include <stdio.h>
+
+
+/*
+ * TEST_0
+ *
+ * Testing signed 16 bits, rounding and saturation, interleaved
+ */
+static bool s_test_convert_output_t0(void)
+{
+    const float src[6] = {0.0f, 0.5f, -0.5f, 1.0f, -1.5f, 1.0f / 65536.0f};
+    int16_t dest[12];
+    uint32_t dither_state = 0;
+
+    for (uint32_t i = 0; i < 12u; ++i)
+    {
+        dest[i] = 0x5555;
+    }
+
+    output_cfg_t cfg = {
+        .fmt = OUTPUT_FMT_S16,
+        .layout = OUTPUT_LAYOUT_INTERLEAVED,
+        .dither = 0,
+        .nch = 2,
+        .plane_len = 0
+    };
+
+    /* Channel 1 only, channel 0 should not be touched */
+    s_convert_output(dest, src, 6, 1, 0, &cfg, &dither_state);
+
+    bool ch_0_b = true;
+    for (uint32_t i = 0; i < 6u; ++i)
+    {
+        ch_0_b = ch_0_b && (dest[2u * i] == 0x5555);
+    }
+
+    bool ch_1_b = (dest[1] == 0) &&
+                  (dest[3] == 16384) &&
+                  (dest[5] == -16384) &&
+                  (dest[7] == 32767) &&
+                  (dest[9] == -32768) &&
+                  (dest[11] == 1);
+
+    return ch_0_b && ch_1_b && (dither_state == 0u);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing signed 24 bits and 32 bits float, planar
+ */
+static bool s_test_convert_output_t1(void)
+{
+    const float src[2] = {-1.0f / 8388608.0f, 2.0f};
+    uint8_t dest_s24[4u * 3u];
+    float dest_f32[4];
+    uint32_t dither_state = 0;
+
+    output_cfg_t cfg = {
+        .fmt = OUTPUT_FMT_S24,
+        .layout = OUTPUT_LAYOUT_PLANAR,
+        .dither = 0,
+        .nch = 2,
+        .plane_len = 2
+    };
+
+    s_convert_output(dest_s24, src, 2, 1, 0, &cfg, &dither_state);
+
+#if !defined (MP3LITE_BIG_ENDIAN)
+    bool s24_b = (dest_s24[6] == 0xFFu) && (dest_s24[7] == 0xFFu) &&
+                 (dest_s24[8] == 0xFFu) &&
+                 (dest_s24[9] == 0xFFu) && (dest_s24[10] == 0xFFu) &&
+                 (dest_s24[11] == 0x7Fu);
+#else
+    bool s24_b = (dest_s24[6] == 0xFFu) && (dest_s24[7] == 0xFFu) &&
+                 (dest_s24[8] == 0xFFu) &&
+                 (dest_s24[9] == 0x7Fu) && (dest_s24[10] == 0xFFu) &&
+                 (dest_s24[11] == 0xFFu);
+#endif
+
+    cfg.fmt = OUTPUT_FMT_F32;
+    s_convert_output(dest_f32, src, 2, 0, 0, &cfg, &dither_state);
+
+    /* Float output is not clipped */
+    bool f32_b = (dest_f32[0] < 0.0f) && (dest_f32[0] > -1.0e-6f) &&
+                 (dest_f32[1] > 1.5f);
+
+    return s24_b && f32_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing TPDF dither, noise must stay within +-1 LSB around the signal,
+ * average to zero, and advance the dither state
+ */
+static bool s_test_convert_output_t2(void)
+{
+    enum { LEN = 4096 };
+    static float src[LEN];
+    static int16_t dest[LEN];
+    uint32_t dither_state = 1234;
+
+    for (uint32_t i = 0; i < LEN; ++i)
+    {
+        src[i] = 100.0f / 32768.0f;
+    }
+
+    output_cfg_t cfg = {
+        .fmt = OUTPUT_FMT_S16,
+        .layout = OUTPUT_LAYOUT_PLANAR,
+        .dither = 1,
+        .nch = 1,
+        .plane_len = LEN
+    };
+
+    s_convert_output(dest, src, LEN, 0, 0, &cfg, &dither_state);
+
+    bool range_b = true;
+    bool varies_b = false;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < LEN; ++i)
+    {
+        range_b = range_b && (dest[i] >= 99) && (dest[i] <= 101);
+        varies_b = varies_b || (dest[i] != 100);
+        sum += dest[i] - 100;
+    }
+
+    bool mean_b = (sum > -(LEN / 32)) && (sum < (LEN / 32));
+    bool state_b = (dither_state == (1234u + LEN));
+
+    return range_b && varies_b && mean_b && state_b;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_convert_output_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_convert_output_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_convert_output_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,118 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+
+/*
+ * TEST_0
+ *
+ * Testing the check value of CRC-16 with polynomial 0x8005 and initial value
+ * 0xFFFF
+ */
+static bool s_test_crc16_t0(void)
+{
+    const uint8_t data[] = "123456789";
+
+    return (s_crc16(CRC_INIT, data, 9) == 0xAEE7u) &&
+           (s_crc16(CRC_INIT, data, 0) == CRC_INIT) &&
+           (s_crc16(s_crc16(CRC_INIT, data, 4), &data[4], 5) == 0xAEE7u);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the table against the bit by bit CRC
+ */
+static bool s_test_crc16_t1(void)
+{
+    uint8_t data[64];
+    uint32_t x = 12345u;
+    bool success = true;
+
+    for (uint32_t len = 0; len <= sizeof(data); ++len)
+    {
+        for (uint32_t i = 0; i < sizeof(data); ++i)
+        {
+            x = (x * 1103515245u) + 12345u;
+            data[i] = (uint8_t) (x >> 16);
+        }
+
+        success = success &&
+                  (s_crc16(CRC_INIT, data, len) ==
+                   s_test_crc16(0xFFFFu, data, len));
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing s_frame_crc_ok() with protected frames, with a bit flipped in the
+ * header, the side information, the CRC and the main data
+ */
+static bool s_test_crc16_t2(void)
+{
+    uint8_t frame[TEST_FRAME_LEN];
+    header_info_t header_info;
+    bool success = true;
+
+    for (uint8_t mode = 0; mode < 4u; ++mode)
+    {
+        (void) s_test_make_protected_frame(frame, mode, 123, 0x5A);
+        success = success &&
+                  !s_decode_frame_header(s_read_frame_header(frame),
+                                         &header_info) &&
+                  header_info.protection &&
+                  s_frame_crc_ok(frame, &header_info);
+
+        const uint32_t side_info_end = HEADER_LEN + CRC_LEN +
+                                       s_side_info_len(&header_info);
+        const uint32_t flips[] = {3, 4, 5, 6, side_info_end - 1u};
+
+        for (uint32_t i = 0; i < (sizeof(flips) / sizeof(flips[0])); ++i)
+        {
+            frame[flips[i]] ^= 0x01u;
+            success = success && !s_frame_crc_ok(frame, &header_info);
+            frame[flips[i]] ^= 0x01u;
+        }
+
+        /* The main data is not covered */
+        frame[side_info_end] ^= 0x01u;
+        success = success && s_frame_crc_ok(frame, &header_info);
+    }
+
+    return success;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_crc16_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_crc16_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_crc16_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
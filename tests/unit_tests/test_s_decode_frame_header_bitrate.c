@@ -230,6 +230,60 @@ static bool s_test_decode_frame_header_bitrate_t2(void)
 }
 
 
+/*
+ * TEST_3
+ *
+ * Testing s_decode_frame_header_bitrate return and header_info.bitrate
+ *
+ * MPEG Audio Version 2 and 2.5 (same table)
+ * Bitrate tested (kbits/s): 160, 8, 144
+ */
+static bool s_test_decode_frame_header_bitrate_t3(void)
+{
+    bool test_3 = false;
+
+    /* ============ MPEG2 160kbps ============ */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0001 0000 1110 0000 0000 0000 */
+    uint32_t frame_header = 0x0010E000;
+    header_info_t header_info;
+
+    bool test_v2_160kbps = s_decode_frame_header_bitrate(frame_header, &header_info);
+
+    if (test_v2_160kbps)
+    {
+        test_v2_160kbps = (header_info.bitrate == 160) ? true : false;
+    }
+
+    /* ============= MPEG2 8kbps ============= */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0001 0000 0001 0000 0000 0000 */
+    frame_header = 0x00101000;
+
+    bool test_v2_8kbps = s_decode_frame_header_bitrate(frame_header, &header_info);
+
+    if (test_v2_8kbps)
+    {
+        test_v2_8kbps = (header_info.bitrate == 8) ? true : false;
+    }
+
+    /* =========== MPEG2.5 144kbps =========== */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0000 0000 1101 0000 0000 0000 */
+    frame_header = 0x0000D000;
+
+    bool test_v25_144kbps = s_decode_frame_header_bitrate(frame_header, &header_info);
+
+    if (test_v25_144kbps)
+    {
+        test_v25_144kbps = (header_info.bitrate == 144) ? true : false;
+    }
+
+    test_3 = test_v2_160kbps && test_v2_8kbps && test_v25_144kbps;
+
+    return test_3;
+}
+
 int main(void)
 {
     int exit_code = 0;
@@ -249,6 +303,11 @@ int main(void)
         exit_code |= TEST_2_FAILED;
     }
 
+    if (!s_test_decode_frame_header_bitrate_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
     if (exit_code)
     {
         printf("    EXIT_CODE: %d\n", exit_code);
@@ -145,6 +145,80 @@ static bool s_test_decode_frame_header_freq_t2(void)
 }
 
 
+/*
+ * TEST_3
+ *
+ * Testing s_decode_frame_header_freq return and header_info.freq
+ *
+ * MPEG Audio Version 2 (half rates) and 2.5 (quarter rates)
+ */
+static bool s_test_decode_frame_header_freq_t3(void)
+{
+    bool test_3 = false;
+
+    /* ============ MPEG2 22050Hz ============ */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0001 0000 0000 0000 0000 0000 */
+    uint32_t frame_header = 0x00100000;
+    header_info_t header_info;
+
+    bool test_v2_22khz = s_decode_frame_header_freq(frame_header, &header_info);
+
+    if (test_v2_22khz)
+    {
+        test_v2_22khz = (header_info.freq == 22050) ? true : false;
+    }
+
+    /* ============ MPEG2 16000Hz ============ */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0001 0000 0000 1000 0000 0000 */
+    frame_header = 0x00100800;
+
+    bool test_v2_16khz = s_decode_frame_header_freq(frame_header, &header_info);
+
+    if (test_v2_16khz)
+    {
+        test_v2_16khz = (header_info.freq == 16000) ? true : false;
+    }
+
+    /* =========== MPEG2.5 12000Hz =========== */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0000 0000 0000 0100 0000 0000 */
+    frame_header = 0x00000400;
+
+    bool test_v25_12khz = s_decode_frame_header_freq(frame_header, &header_info);
+
+    if (test_v25_12khz)
+    {
+        test_v25_12khz = (header_info.freq == 12000) ? true : false;
+    }
+
+    /* =========== MPEG2.5 8000Hz ============ */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0000 0000 0000 1000 0000 0000 */
+    frame_header = 0x00000800;
+
+    bool test_v25_8khz = s_decode_frame_header_freq(frame_header, &header_info);
+
+    if (test_v25_8khz)
+    {
+        test_v25_8khz = (header_info.freq == 8000) ? true : false;
+    }
+
+    /* ========== MPEG2.5 reserved =========== */
+    /* AAAA AAAA AAAB BCCD EEEE FFGH IIJJ KLMM */
+    /* 0000 0000 0000 0000 0000 1100 0000 0000 */
+    frame_header = 0x00000C00;
+
+    bool test_v25_reserv = !s_decode_frame_header_freq(frame_header,
+                                                       &header_info);
+
+    test_3 = test_v2_22khz && test_v2_16khz && test_v25_12khz &&
+             test_v25_8khz && test_v25_reserv;
+
+    return test_3;
+}
+
 int main(void)
 {
     int exit_code = 0;
@@ -164,6 +238,11 @@ int main(void)
         exit_code |= TEST_2_FAILED;
     }
 
+    if (!s_test_decode_frame_header_freq_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
     if (exit_code)
     {
         printf("    EXIT_CODE: %d\n", exit_code);
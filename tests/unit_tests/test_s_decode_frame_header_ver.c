@@ -27,7 +27,7 @@
  /*
  * TEST_0
  *
- * Testing Version ID, currently only supporting MPEG-1
+ * Testing Version ID, MPEG-1, 2 and 2.5 are supported
  */
 static bool s_test_decode_frame_header_ver_t0(void)
 {
@@ -49,7 +49,6 @@ static bool s_test_decode_frame_header_ver_t0(void)
     /* 0000 0000 0001 0000 0000 0000 0000 0000 */
     frame_header = 0x00100000;
     bool ver_2 = s_decode_frame_header_ver(frame_header, &header_info);
-    ver_2 = !ver_2; // return false for non-MPEG-1 versions
     if (ver_2)
     {
         ver_2 = (header_info.ver == 2) ? true : false;
@@ -60,7 +59,6 @@ static bool s_test_decode_frame_header_ver_t0(void)
     /* 0000 0000 0000 0000 0000 0000 0000 0000 */
     frame_header = 0x00000000;
     bool ver_25 = s_decode_frame_header_ver(frame_header, &header_info);
-    ver_25 = !ver_25; // return false for non-MPEG-1 versions
     if (ver_25)
     {
         ver_25 = (header_info.ver == 25) ? true : false;
@@ -0,0 +1,126 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+
+#include <stdio.h>
+
+
+/*
+ * Checking the partitions of one granule and channel
+ */
+static bool s_check(const uint8_t ch,
+                    const uint16_t scalefac_compress,
+                    const uint8_t block_type,
+                    const uint8_t mixed_block_flag,
+                    const uint8_t mode_ext,
+                    const uint8_t *slen_expected,
+                    const uint8_t *nr_expected,
+                    const uint32_t part2_length)
+{
+    header_info_t header_info;
+    memset(&header_info, 0, sizeof(header_info));
+    header_info.ver = 2;
+    header_info.mode = 1;
+    header_info.mode_ext = mode_ext;
+
+    side_info_gr_ch_t gr_ch;
+    memset(&gr_ch, 0, sizeof(gr_ch));
+    gr_ch.scalefac_compress = scalefac_compress;
+    gr_ch.window_switching_flag = (block_type == 0u) ? 0 : 1;
+    gr_ch.block_type = block_type;
+    gr_ch.mixed_block_flag = mixed_block_flag;
+
+    uint8_t slen[4];
+    uint8_t nr_of_sfb[4];
+    bool success = (s_decode_scalefac_lsf_partition(slen, nr_of_sfb, ch,
+                                                    &gr_ch, &header_info) ==
+                    part2_length);
+
+    for (uint8_t i = 0; i < 4u; ++i)
+    {
+        success = success && (slen[i] == slen_expected[i]) &&
+                  (nr_of_sfb[i] == nr_expected[i]);
+    }
+
+    return success;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing the three tables without intensity stereo
+ */
+static bool s_test_decode_scalefac_lsf_partition_t0(void)
+{
+    /* 399: slen = 24 / 5, 24 % 5, 15 >> 2, 15 & 3 */
+    const uint8_t slen_0[4] = {4, 4, 3, 3};
+    const uint8_t nr_0[4] = {6, 5, 5, 5};
+
+    /* 450: slen = 12 / 5, 12 % 5, 50 & 3 */
+    const uint8_t slen_1[4] = {2, 2, 2, 0};
+    const uint8_t nr_1[4] = {9, 9, 12, 6};
+
+    /* 511: slen = 11 / 3, 11 % 3 */
+    const uint8_t slen_2[4] = {3, 2, 0, 0};
+    const uint8_t nr_2[4] = {15, 18, 0, 0};
+
+    /* Intensity stereo is only for the right channel */
+    const uint8_t slen_3[4] = {0, 0, 0, 0};
+    const uint8_t nr_3[4] = {11, 10, 0, 0};
+
+    return s_check(0, 399, 0, 0, 0, slen_0, nr_0, 74) &&
+           s_check(1, 450, 2, 0, 0, slen_1, nr_1, 60) &&
+           s_check(1, 511, 2, 1, 0, slen_2, nr_2, 81) &&
+           s_check(0, 500, 1, 0, 1, slen_3, nr_3, 0);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the three tables of the right channel of intensity stereo,
+ * scalefac_compress / 2 selects the partitions
+ */
+static bool s_test_decode_scalefac_lsf_partition_t1(void)
+{
+    /* 100: slen = 100 / 36, 28 / 6, 28 % 6 */
+    const uint8_t slen_3[4] = {2, 4, 4, 0};
+    const uint8_t nr_3[4] = {7, 7, 7, 0};
+
+    /* 200 - 180: slen = 20 >> 4, (20 & 15) >> 2, 20 & 3 */
+    const uint8_t slen_4[4] = {1, 1, 0, 0};
+    const uint8_t nr_4[4] = {12, 9, 9, 6};
+
+    /* 250 - 244: slen = 6 / 3, 6 % 3 */
+    const uint8_t slen_5[4] = {2, 0, 0, 0};
+    const uint8_t nr_5[4] = {8, 8, 5, 0};
+
+    /* intensity_scale (bit 0) does not change the partitions */
+    return s_check(1, 200, 0, 0, 1, slen_3, nr_3, 70) &&
+           s_check(1, 201, 0, 0, 3, slen_3, nr_3, 70) &&
+           s_check(1, 401, 2, 0, 1, slen_4, nr_4, 21) &&
+           s_check(1, 500, 3, 0, 1, slen_5, nr_5, 16);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decode_scalefac_lsf_partition_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decode_scalefac_lsf_partition_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -37,7 +37,7 @@ static bool s_test_decode_side_info_t0(void)
     
     /* si.bit frame 21: mono, 17B, main_data_begin = 511 */
     uint32_t si_bit_f21_header = 0xfffb52c0;
-    si_bit_f1_header = s_swap_endian_u32(si_bit_f21_header);
+    si_bit_f21_header = s_swap_endian_u32(si_bit_f21_header);
     const uint8_t si_bit_f21[17] = {
         0xff, 0x80, 0x2b, 0xac, 0x9c, 
         0xc8, 0x0b, 0xde, 0xeb, 0x05, 
@@ -95,6 +95,128 @@ static bool s_test_decode_side_info_t1(void)
     return test_1;
 }
 
+/*
+ * Writing the len lowest bits of val at bit pos, most significant bit first
+ *
+ * \return  The bit position after the written bits
+ */
+static uint32_t s_put_bits(uint8_t *buf,
+                           uint32_t pos,
+                           const uint32_t val,
+                           const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        uint8_t bit = (uint8_t) ((val >> (len - 1u - i)) & 0x01u);
+        buf[pos / 8u] = (uint8_t) (buf[pos / 8u] | (bit << (7u - (pos % 8u))));
+        ++pos;
+    }
+
+    return pos;
+}
+
+
+/*
+* TEST_2
+*
+* Testing MPEG-2 joint stereo (intensity), a single granule, 9 bits
+* scalefac_compress, the derived preflag and the 8 bits main_data_begin
+*/
+static bool s_test_decode_side_info_t2(void)
+{
+    /* MPEG-2, 64 kbits/s, 22050 Hz, joint stereo, intensity */
+    uint32_t header = s_swap_endian_u32(0xfff38050);
+    uint8_t si[17] = {0};
+
+    uint32_t pos = s_put_bits(si, 0, 200, 8);  /* main_data_begin */
+    pos = s_put_bits(si, pos, 0, 2);            /* private_bits */
+
+    /* ch 0: long blocks */
+    pos = s_put_bits(si, pos, 1234, 12);
+    pos = s_put_bits(si, pos, 300, 9);
+    pos = s_put_bits(si, pos, 180, 8);
+    pos = s_put_bits(si, pos, 505, 9);
+    pos = s_put_bits(si, pos, 0, 1);
+    pos = s_put_bits(si, pos, 1, 5);
+    pos = s_put_bits(si, pos, 2, 5);
+    pos = s_put_bits(si, pos, 3, 5);
+    pos = s_put_bits(si, pos, 5, 4);
+    pos = s_put_bits(si, pos, 6, 3);
+    pos = s_put_bits(si, pos, 1, 1);
+    pos = s_put_bits(si, pos, 0, 1);
+
+    /* ch 1: mixed short blocks */
+    pos = s_put_bits(si, pos, 100, 12);
+    pos = s_put_bits(si, pos, 10, 9);
+    pos = s_put_bits(si, pos, 140, 8);
+    pos = s_put_bits(si, pos, 300, 9);
+    pos = s_put_bits(si, pos, 1, 1);
+    pos = s_put_bits(si, pos, 2, 2);
+    pos = s_put_bits(si, pos, 1, 1);
+    pos = s_put_bits(si, pos, 7, 5);
+    pos = s_put_bits(si, pos, 8, 5);
+    pos = s_put_bits(si, pos, 1, 3);
+    pos = s_put_bits(si, pos, 2, 3);
+    pos = s_put_bits(si, pos, 3, 3);
+    pos = s_put_bits(si, pos, 0, 1);
+    pos = s_put_bits(si, pos, 1, 1);
+
+    side_info_t side_info;
+    header_info_t header_info;
+    bool header_b = (s_decode_frame_header(header, &header_info) == 0) &&
+                    (s_side_info_len(&header_info) == 17u) && (pos == 136u);
+    bool decode_b = header_b &&
+                    (s_decode_side_info(si, &side_info, &header_info) == 0);
+
+    const side_info_gr_ch_t *ch0 = &side_info.gr_ch[s_gr_ch_idx(0, 0)];
+    const side_info_gr_ch_t *ch1 = &side_info.gr_ch[s_gr_ch_idx(0, 1)];
+
+    bool ch0_b = decode_b && (side_info.main_data_begin == 200u) &&
+                 (ch0->part2_3_length == 1234u) && (ch0->big_values == 300u) &&
+                 (ch0->global_gain == 180u) &&
+                 (ch0->scalefac_compress == 505u) &&
+                 (ch0->window_switching_flag == 0u) &&
+                 (ch0->block_type == 0u) && (ch0->table_select[0] == 1u) &&
+                 (ch0->table_select[1] == 2u) && (ch0->table_select[2] == 3u) &&
+                 (ch0->region_count[0] == 5u) && (ch0->region_count[1] == 6u) &&
+                 (ch0->preflag == 1u) && (ch0->scalefac_scale == 1u) &&
+                 (ch0->count1table_select == 0u) &&
+                 (side_info.scfsi[s_scfsi_idx(0, 0)] == 0u);
+
+    bool ch1_b = decode_b && (ch1->part2_3_length == 100u) &&
+                 (ch1->big_values == 10u) && (ch1->global_gain == 140u) &&
+                 (ch1->scalefac_compress == 300u) &&
+                 (ch1->window_switching_flag == 1u) &&
+                 (ch1->block_type == 2u) && (ch1->mixed_block_flag == 1u) &&
+                 (ch1->table_select[0] == 7u) && (ch1->table_select[1] == 8u) &&
+                 (ch1->subblock_gain[0] == 1u) &&
+                 (ch1->subblock_gain[1] == 2u) &&
+                 (ch1->subblock_gain[2] == 3u) &&
+                 (ch1->preflag == 0u) && (ch1->scalefac_scale == 0u) &&
+                 (ch1->count1table_select == 1u);
+
+    /* MPEG-2.5 mono, 9 bytes */
+    header = s_swap_endian_u32(0xffe380c0);
+    uint8_t si_mono[9] = {0};
+    pos = s_put_bits(si_mono, 0, 255, 8);
+    pos = s_put_bits(si_mono, pos, 0, 1);
+    pos = s_put_bits(si_mono, pos, 4095, 12);
+    pos = s_put_bits(si_mono, pos, 0, 9 + 8);
+    pos = s_put_bits(si_mono, pos, 511, 9);
+
+    bool mono_b = (s_decode_frame_header(header, &header_info) == 0) &&
+                  (header_info.ver == 25u) && (header_info.freq == 11025u) &&
+                  (s_side_info_len(&header_info) == 9u) &&
+                  (s_decode_side_info(si_mono, &side_info, &header_info) ==
+                   0) &&
+                  (side_info.main_data_begin == 255u) &&
+                  (side_info.gr_ch[0].part2_3_length == 4095u) &&
+                  (side_info.gr_ch[0].scalefac_compress == 511u) &&
+                  (side_info.gr_ch[0].preflag == 1u);
+
+    return ch0_b && ch1_b && mono_b;
+}
+
 /* si.bit frame 64: mono, 17B */
 /* GR0: scalefactors: slen1 = 0 slen2 = 1 */
 /* GR1: scalefactors: slen1 = 0 slen2 = 2 */
@@ -119,6 +241,11 @@ int main(void)
         exit_code |= TEST_1_FAILED;
     }
 
+    if (!s_test_decode_side_info_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
     if (exit_code)
     {
         printf("    EXIT_CODE: %d\n", exit_code);
@@ -0,0 +1,106 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+
+/*
+ * TEST_0
+ *
+ * Testing an Info frame with a LAME tag
+ */
+static bool s_test_decode_xing_t0(void)
+{
+    uint8_t frame[TEST_FRAME_LEN];
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+
+    (void) s_test_make_info_frame(frame, 10, 576, 1000);
+
+    /* 10 * 1152 - 576 - 1000 */
+    return s_frame_header_valid(frame, &header_info) &&
+           s_decode_xing(frame, &header_info, &gapless) &&
+           (gapless.enc_delay == 576u) && (gapless.enc_padding == 1000u) &&
+           (gapless.skip == (576u + DECODER_DELAY)) &&
+           (gapless.nsamples == 9944u);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing a Xing tag with the number of frames only and no LAME tag, and a
+ * frame without a tag
+ */
+static bool s_test_decode_xing_t1(void)
+{
+    uint8_t frame[TEST_FRAME_LEN];
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+
+    (void) s_test_make_info_frame(frame, 3, 576, 1000);
+    memcpy(&frame[21], "Xing", 4);
+    frame[28] = 0x01;
+
+    /* The LAME tag is looked for right after the number of frames */
+    bool xing_b = s_frame_header_valid(frame, &header_info) &&
+                  s_decode_xing(frame, &header_info, &gapless) &&
+                  (gapless.enc_delay == 0u) && (gapless.enc_padding == 0u) &&
+                  (gapless.skip == 0u) && (gapless.nsamples == 3456u);
+
+    (void) s_test_make_frame(frame, 3, 0, 'I');
+
+    bool audio_b = s_frame_header_valid(frame, &header_info) &&
+                   !s_decode_xing(frame, &header_info, &gapless);
+
+    return xing_b && audio_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing an Info tag without the number of frames, the length is unknown
+ */
+static bool s_test_decode_xing_t2(void)
+{
+    uint8_t frame[TEST_FRAME_LEN];
+    header_info_t header_info;
+    mp3lite_gapless_t gapless;
+
+    (void) s_test_make_info_frame(frame, 10, 576, 1000);
+    frame[28] = 0x00;
+
+    return s_frame_header_valid(frame, &header_info) &&
+           s_decode_xing(frame, &header_info, &gapless) &&
+           (gapless.nsamples == 0u);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_decode_xing_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_decode_xing_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_decode_xing_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
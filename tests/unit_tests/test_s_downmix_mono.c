@@ -0,0 +1,127 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+
+#include <stdio.h>
+
+
+/*
+ * TEST_0
+ *
+ * Testing the average of the two channels
+ */
+static bool s_test_downmix_mono_t0(void)
+{
+    bool test_0 = true;
+
+    float xr_0[GRANULE_LEN];
+    float xr_1[GRANULE_LEN];
+
+    for (uint32_t i = 0; i < GRANULE_LEN; ++i)
+    {
+        xr_0[i] = (float) i;
+        xr_1[i] = -3.0f * (float) i + 2.0f;
+    }
+
+    s_downmix_mono(xr_0, xr_1);
+
+    for (uint32_t i = 0; i < GRANULE_LEN; ++i)
+    {
+        /* (i + (-3i + 2)) / 2 = 1 - i, exact in float */
+        float expected = 1.0f - (float) i;
+        if ((xr_0[i] < expected) || (xr_0[i] > expected))
+        {
+            test_0 = false;
+        }
+    }
+
+    return test_0;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing the number of synthesis channels for each mode
+ */
+static bool s_test_downmix_mono_t1(void)
+{
+    header_info_t header_info;
+
+    header_info.mode = 0;
+    bool stereo_b = (s_synthesis_nch(&header_info, true) == 1u) &&
+                    (s_synthesis_nch(&header_info, false) == 2u);
+
+    header_info.mode = 1;
+    bool joint_b = (s_synthesis_nch(&header_info, true) == 1u) &&
+                   (s_synthesis_nch(&header_info, false) == 2u);
+
+    /* Dual channel is never mixed */
+    header_info.mode = 2;
+    bool dual_b = (s_synthesis_nch(&header_info, true) == 2u) &&
+                  (s_synthesis_nch(&header_info, false) == 2u);
+
+    header_info.mode = 3;
+    bool mono_b = (s_synthesis_nch(&header_info, true) == 1u) &&
+                  (s_synthesis_nch(&header_info, false) == 1u);
+
+    return stereo_b && joint_b && dual_b && mono_b;
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing whether the spectra can be mixed before the IMDCT
+ */
+static bool s_test_downmix_mono_t2(void)
+{
+    side_info_gr_ch_t gr_ch_0;
+    side_info_gr_ch_t gr_ch_1;
+
+    /* Both long blocks (window_switching_flag = 0) */
+    gr_ch_0.block_type = 0;
+    gr_ch_0.mixed_block_flag = 0xFF;
+    gr_ch_1.block_type = 0;
+    gr_ch_1.mixed_block_flag = 0xFF;
+    bool long_b = s_downmix_spectrum_b(&gr_ch_0, &gr_ch_1);
+
+    /* Long and short blocks */
+    gr_ch_1.block_type = 2;
+    gr_ch_1.mixed_block_flag = 0;
+    bool long_short_b = !s_downmix_spectrum_b(&gr_ch_0, &gr_ch_1);
+
+    /* Short blocks, only one of them mixed */
+    gr_ch_0.block_type = 2;
+    gr_ch_0.mixed_block_flag = 1;
+    bool mixed_b = !s_downmix_spectrum_b(&gr_ch_0, &gr_ch_1);
+
+    return long_b && long_short_b && mixed_b;
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_downmix_mono_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_downmix_mono_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_downmix_mono_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,198 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+
+#include <stdio.h>
+
+#define FREQ        48000u
+#define BLOCK_LEN   32u
+
+/* Meter under test, static for its size */
+static loudness_t s_loudness;
+
+
+static bool s_near(const double x, const double expected, const double tol)
+{
+    return ((x - expected) <= tol) && ((expected - x) <= tol);
+}
+
+
+/*
+ * Feeding a stereo 1 kHz sine of peak amplitude amp for nsec seconds through
+ * s_convert_output(), BLOCK_LEN samples per channel at a time as the
+ * synthesis does
+ */
+static void s_feed_sine(loudness_t *loudness,
+                        const double amp,
+                        const uint32_t nsec)
+{
+    /* cos and sin of 2 * pi * 1000 / 48000 */
+    const double c = 0.99144486137381041;
+    const double s = 0.13052619222005157;
+
+    output_cfg_t cfg = {.fmt = OUTPUT_FMT_S16, .nch = 2,
+                        .layout = OUTPUT_LAYOUT_INTERLEAVED,
+                        .loudness = loudness};
+    int16_t dest[BLOCK_LEN * 2u];
+    float src[BLOCK_LEN];
+    uint32_t dither_state = 0;
+
+    s_loudness_set_format(loudness, FREQ, 2);
+
+    /* Starting at 0 to avoid an overshoot, samples 12 + 48 * k are the peaks */
+    double re = amp;
+    double im = 0.0;
+    for (uint32_t n = 0; n < ((nsec * FREQ) / BLOCK_LEN); ++n)
+    {
+        for (uint32_t i = 0; i < BLOCK_LEN; ++i)
+        {
+            src[i] = (float) im;
+            const double re_next = (re * c) - (im * s);
+            im = (re * s) + (im * c);
+            re = re_next;
+        }
+
+        s_convert_output(dest, src, BLOCK_LEN, 0, 0, &cfg, &dither_state);
+        s_convert_output(dest, src, BLOCK_LEN, 1, 0, &cfg, &dither_state);
+    }
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing a stereo 1 kHz sine at -23 dBFS, which is -23 LUFS
+ */
+static bool s_test_loudness_t0(void)
+{
+    loudness_t *loudness = &s_loudness;
+    s_loudness_init(loudness);
+    loudness_result_t result;
+
+    /* 10^(-23 / 20) */
+    s_feed_sine(loudness, 0.070794578438413791, 20);
+
+    return (s_loudness_result(loudness, &result) == MP3LITE_OK) &&
+           s_near(result.integrated, -23.0, 0.1) &&
+           s_near(result.range, 0.0, 0.1) &&
+           s_near(result.true_peak, -23.0, 0.05) &&
+           s_near(result.sample_peak, -23.0, 0.05) &&
+           s_near(result.replay_gain, 5.0, 0.1);
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing 20 s at -23 LUFS then 20 s at -33 LUFS, integrated is the mean
+ * energy of both and the range is the step
+ */
+static bool s_test_loudness_t1(void)
+{
+    loudness_t *loudness = &s_loudness;
+    s_loudness_init(loudness);
+    loudness_result_t result;
+
+    /* 10^(-23 / 20), 10^(-33 / 20) */
+    s_feed_sine(loudness, 0.070794578438413791, 20);
+    s_feed_sine(loudness, 0.022387211385683396, 20);
+
+    /* -23 + 10 * log10((1 + 0.1) / 2) */
+    return (s_loudness_result(loudness, &result) == MP3LITE_OK) &&
+           s_near(result.integrated, -25.596, 0.1) &&
+           s_near(result.range, 10.0, 0.2) &&
+           s_near(result.true_peak, -23.0, 0.05);
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing silence, too short input and s_db10()
+ */
+static bool s_test_loudness_t2(void)
+{
+    loudness_t *loudness = &s_loudness;
+    s_loudness_init(loudness);
+    loudness_result_t result;
+
+    bool success = (s_loudness_result(loudness, &result) ==
+                    MP3LITE_NEED_MORE_DATA);
+
+    s_feed_sine(loudness, 0.0, 5);
+    success = success &&
+              (s_loudness_result(loudness, &result) ==
+               MP3LITE_NEED_MORE_DATA);
+
+    success = success &&
+              s_near(s_db10(1.0), 0.0, 1e-9) &&
+              s_near(s_db10(2.0), 3.0102999566, 1e-9) &&
+              s_near(s_db10(1e-7), -70.0, 1e-9) &&
+              s_near(s_db10(0.5e5), 46.9897000434, 1e-9);
+
+    return success;
+}
+
+
+/*
+ * TEST_3
+ *
+ * Testing sub-blocks at 11025 Hz, 10 of them are exactly one second
+ */
+static bool s_test_loudness_t3(void)
+{
+    loudness_t *loudness = &s_loudness;
+    s_loudness_init(loudness);
+    float src[1225];
+    for (uint32_t i = 0; i < 1225u; ++i)
+    {
+        src[i] = ((i % 2u) == 0u) ? 0.25f : -0.25f;
+    }
+
+    s_loudness_set_format(loudness, 11025, 1);
+    bool len_b = (s_loudness_sub_len(11025, 0) == 1102u) &&
+                 (s_loudness_sub_len(11025, 1) == 1103u) &&
+                 (s_loudness_sub_len(11025, 9) == 1103u);
+
+    /* 9 * 1225 = 11025 */
+    for (uint32_t n = 0; n < 9u; ++n)
+    {
+        s_loudness_process(loudness, src, 1225, 0);
+    }
+
+    return len_b && (loudness->nsub[0] == 10u) &&
+           (loudness->sub_count[0] == 0u) &&
+           (loudness->sub_len[0] == 1102u);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_loudness_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_loudness_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_loudness_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (!s_test_loudness_t3())
+    {
+        exit_code |= TEST_3_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,174 @@
+#include "../../mp3lite.c"
+#include "../test_exit_code.h"
+#include "../test_frames.h"
+
+#include <stdio.h>
+
+static uint8_t s_stream[16384];
+
+
+/*
+ * Writing an ID3v2 header with a syncsafe size
+ *
+ * \return  Tag length in bytes, the body is filled with false syncs
+ */
+static uint32_t s_make_id3v2(uint8_t *buf,
+                             const uint32_t size,
+                             const bool footer)
+{
+    buf[0] = 'I';
+    buf[1] = 'D';
+    buf[2] = '3';
+    buf[3] = 4;
+    buf[4] = 0;
+    buf[5] = (footer) ? 0x10u : 0;
+    buf[6] = (uint8_t) ((size >> 21) & 0x7Fu);
+    buf[7] = (uint8_t) ((size >> 14) & 0x7Fu);
+    buf[8] = (uint8_t) ((size >> 7) & 0x7Fu);
+    buf[9] = (uint8_t) (size & 0x7Fu);
+
+    uint32_t len = ID3V2_HEADER_LEN + size + ((footer) ? 10u : 0);
+    memset(&buf[ID3V2_HEADER_LEN], 0xFF, len - ID3V2_HEADER_LEN);
+
+    return len;
+}
+
+
+/*
+ * Writing an APEv2 tag with a header, body_len bytes of items and a footer
+ *
+ * \return  Tag length in bytes
+ */
+static uint32_t s_make_ape(uint8_t *buf, const uint32_t body_len)
+{
+    const uint32_t size = body_len + APE_FOOTER_LEN;
+    uint8_t footer[APE_FOOTER_LEN];
+
+    memset(footer, 0, sizeof(footer));
+    memcpy(footer, "APETAGEX", 8);
+    footer[12] = (uint8_t) size;
+    footer[13] = (uint8_t) (size >> 8);
+    footer[23] = 0x80u;
+
+    memcpy(buf, footer, APE_FOOTER_LEN);
+    memset(&buf[APE_FOOTER_LEN], 0xFF, body_len);
+    memcpy(&buf[APE_FOOTER_LEN + body_len], footer, APE_FOOTER_LEN);
+
+    return size + APE_FOOTER_LEN;
+}
+
+
+/*
+ * TEST_0
+ *
+ * Testing ID3v2 tags, with a footer and back to back
+ */
+static bool s_test_stream_bounds_t0(void)
+{
+    size_t start = 0;
+    size_t end = 0;
+
+    uint32_t len = s_make_id3v2(s_stream, 1000, true);
+    uint32_t audio = len;
+    len += s_test_make_frame(&s_stream[len], 0, 0, 0);
+
+    s_stream_bounds(s_stream, len, &start, &end);
+    bool success = (start == audio) && (end == len) && (audio == 1020u) &&
+                   (s_id3v2_len(s_stream) == 1020u);
+
+    len = s_make_id3v2(s_stream, 300, false);
+    len += s_make_id3v2(&s_stream[len], 5000, false);
+    audio = len;
+    len += s_test_make_frame(&s_stream[len], 0, 0, 0);
+
+    s_stream_bounds(s_stream, len, &start, &end);
+    success = success && (start == audio) && (end == len);
+
+    /* Truncated tag, invalid syncsafe byte */
+    s_stream_bounds(s_stream, 200, &start, &end);
+    success = success && (start == 200u) && (end == 200u);
+
+    s_stream[7] |= 0x80u;
+    success = success && (s_id3v2_len(s_stream) == 0u);
+
+    return success;
+}
+
+
+/*
+ * TEST_1
+ *
+ * Testing ID3v1 and APEv2 tags at the end
+ */
+static bool s_test_stream_bounds_t1(void)
+{
+    size_t start = 0;
+    size_t end = 0;
+
+    uint32_t len = s_test_make_frame(s_stream, 0, 0, 0);
+    const uint32_t audio = len;
+
+    len += s_make_ape(&s_stream[len], 500);
+    s_stream_bounds(s_stream, len, &start, &end);
+    bool success = (start == 0u) && (end == audio);
+
+    memset(&s_stream[len], 0, ID3V1_LEN);
+    memcpy(&s_stream[len], "TAG", 3);
+    len += ID3V1_LEN;
+    s_stream_bounds(s_stream, len, &start, &end);
+    success = success && (start == 0u) && (end == audio);
+
+    /* ID3v1 alone */
+    memset(&s_stream[audio], 0, ID3V1_LEN);
+    memcpy(&s_stream[audio], "TAG", 3);
+    s_stream_bounds(s_stream, audio + ID3V1_LEN, &start, &end);
+    success = success && (end == audio);
+
+    /* No tags */
+    s_stream_bounds(s_stream, audio, &start, &end);
+    return success && (start == 0u) && (end == audio);
+}
+
+
+/*
+ * TEST_2
+ *
+ * Testing s_id3v2_partial()
+ */
+static bool s_test_stream_bounds_t2(void)
+{
+    const uint8_t id3[4] = {'I', 'D', '3', 4};
+    const uint8_t other[4] = {'I', 'D', 'X', 4};
+
+    return s_id3v2_partial(id3, 0) && s_id3v2_partial(id3, 2) &&
+           s_id3v2_partial(id3, 4) && !s_id3v2_partial(other, 4) &&
+           !s_id3v2_partial(id3, ID3V2_HEADER_LEN);
+}
+
+
+int main(void)
+{
+    int exit_code = 0;
+
+    if (!s_test_stream_bounds_t0())
+    {
+        exit_code |= TEST_0_FAILED;
+    }
+
+    if (!s_test_stream_bounds_t1())
+    {
+        exit_code |= TEST_1_FAILED;
+    }
+
+    if (!s_test_stream_bounds_t2())
+    {
+        exit_code |= TEST_2_FAILED;
+    }
+
+    if (exit_code)
+    {
+        printf("    EXIT_CODE: %d\n", exit_code);
+    }
+
+    return exit_code;
+}